@@ -0,0 +1,14 @@
+# Standalone CRC32 throughput benchmark. Build and run with:
+# qmake && make && ./crc32-benchmark
+TEMPLATE = app
+TARGET = crc32-benchmark
+CONFIG += console release
+CONFIG -= app_bundle
+QT = core
+QMAKE_CXXFLAGS += -std=c++11
+INCLUDEPATH += ../../src
+LIBS += -lz
+
+SOURCES += main.cpp \
+           ../../src/crc32.cpp
+HEADERS += ../../src/crc32.h
@@ -0,0 +1,132 @@
+/***************************************************************************
+ *            main.cpp
+ *
+ *  Sat Oct 17 23:45:48 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+// Measures the throughput of the rom checksum CRC32 in GB/s. The engine
+// Skyscraper picks for this cpu and the table based engine are compared with
+// the byte at a time loop used before, and every result is checked against
+// zlib's crc32().
+
+#include <cstdio>
+
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QList>
+
+#include <zlib.h>
+
+#include "crc32.h"
+
+#define BUFFERSIZE (64 * 1024 * 1024)
+#define MINTIME 1000000000LL // Repeat each engine for at least a second
+
+// The implementation Skyscraper used before, one table lookup per byte
+static quint32 updateBytewise(quint32 crc, const uchar *data, qint64 len)
+{
+  static quint32 table[256];
+  if(table[1] == 0) {
+    for(int a = 0; a < 256; ++a) {
+      quint32 value = a;
+      for(int b = 0; b < 8; ++b) {
+	value = value & 1 ? (value >> 1) ^ 0xEDB88320UL : value >> 1;
+      }
+      table[a] = value;
+    }
+  }
+  for(qint64 a = 0; a < len; ++a) {
+    crc = table[(crc ^ data[a]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+static quint32 updateZlib(quint32 crc, const uchar *data, qint64 len)
+{
+  // zlib takes and returns the final value, not the running one
+  return crc32(crc ^ 0xFFFFFFFFUL, data, len) ^ 0xFFFFFFFFUL;
+}
+
+struct Engine {
+  const char *name;
+  quint32 (*update)(quint32 crc, const uchar *data, qint64 len);
+};
+
+int main()
+{
+  QByteArray buffer(BUFFERSIZE, '\0');
+  quint32 state = 42;
+  for(int a = 0; a < buffer.size(); ++a) {
+    state = state * 1664525 + 1013904223;
+    buffer[a] = (char)(state >> 24);
+  }
+  const uchar *data = (const uchar *)buffer.constData();
+
+  // Odd lengths and offsets make sure the unaligned head and tail are covered too
+  bool correct = true;
+  QList<Engine> engines({{"bytewise (old)", updateBytewise},
+			 {"slice-by-8", Crc32::updateSoftware},
+			 {"default", Crc32::update},
+			 {"zlib", updateZlib}});
+  for(const auto &engine: engines) {
+    for(int length = 0; length < 1024; ++length) {
+      for(int offset = 0; offset < 16; ++offset) {
+	if((engine.update(0xFFFFFFFFUL, data + offset, length) ^ 0xFFFFFFFFUL) !=
+	   crc32(0, data + offset, length)) {
+	  printf("'%s' gives a wrong result for %d bytes at offset %d!\n",
+		 engine.name, length, offset);
+	  correct = false;
+	  break;
+	}
+      }
+    }
+  }
+
+  printf("Default engine is %s\n",
+	 Crc32::isHardwareAccelerated()?"hardware accelerated":"slice-by-8");
+  printf("%16s %10s %10s\n", "engine", "GB/s", "speedup");
+  double bytewiseSpeed = 0;
+  for(const auto &engine: engines) {
+    quint32 crc = 0xFFFFFFFFUL;
+    qint64 bytes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do {
+      crc = engine.update(crc, data, buffer.size());
+      bytes += buffer.size();
+    } while(timer.nsecsElapsed() < MINTIME);
+    double speed = (double)bytes / timer.nsecsElapsed();
+    if(bytewiseSpeed == 0) {
+      bytewiseSpeed = speed;
+    }
+    // Also keeps the compiler from dropping the loop
+    if(crc == 0) {
+      printf("Unlikely but possible zero crc for '%s'\n", engine.name);
+    }
+    printf("%16s %10.2f %9.1fx\n", engine.name, speed, speed / bytewiseSpeed);
+  }
+  if(!correct) {
+    printf("Results differ from zlib, the CRC32 implementation is broken!\n");
+    return 1;
+  }
+  return 0;
+}
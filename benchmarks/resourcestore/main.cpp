@@ -0,0 +1,122 @@
+/***************************************************************************
+ *            main.cpp
+ *
+ *  Sat Oct 17 23:40:05 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+// Measures ResourceStore lookups at growing cache sizes. The time per lookup
+// should stay flat from 10k to 1M resources. The plain list scan the cache
+// used before is measured alongside it for the smaller sizes.
+
+#include <cstdio>
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QVector>
+#include <QString>
+
+#include "resourcestore.h"
+
+#define LOOKUPS 1000000
+#define SCANLOOKUPS 200
+
+static const char *types[] = {"title", "platform", "description", "cover",
+			      "screenshot", "wheel", "marquee", "video"};
+static const char *sources[] = {"screenscraper", "thegamesdb", "arcadedb", "igdb"};
+
+static Resource makeResource(const int &number)
+{
+  // Every cache id gets a full set of types from one source, like after a scraping run
+  Resource resource;
+  resource.cacheId = QString::number(number / 8, 16).rightJustified(40, '0');
+  resource.type = types[number % 8];
+  resource.source = sources[(number / 8) % 4];
+  resource.value = "value " + QString::number(number);
+  return resource;
+}
+
+// Simple deterministic generator so every run looks up the same resources
+static quint32 nextRandom(quint32 &state)
+{
+  state = state * 1664525 + 1013904223;
+  return state >> 8;
+}
+
+int main()
+{
+  printf("%10s %18s %18s\n", "resources", "store ns/lookup", "scan ns/lookup");
+  for(const auto &count: QList<int>({10000, 100000, 1000000})) {
+    ResourceStore store;
+    QList<Resource> list;
+    for(int a = 0; a < count; ++a) {
+      Resource resource = makeResource(a);
+      store.append(resource);
+      if(count <= 100000) {
+	list.append(resource);
+      }
+    }
+    // Look up the keys up front so only the lookups themselves are timed
+    QVector<Resource> keys;
+    keys.reserve(LOOKUPS);
+    quint32 state = 42;
+    for(int a = 0; a < LOOKUPS; ++a) {
+      keys.append(makeResource(nextRandom(state) % count));
+    }
+
+    int found = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for(const auto &key: keys) {
+      if(store.contains(key.cacheId, key.type, key.source)) {
+	found++;
+      }
+    }
+    double storeTime = (double)timer.nsecsElapsed() / LOOKUPS;
+
+    double scanTime = -1;
+    if(!list.isEmpty()) {
+      timer.start();
+      for(int a = 0; a < SCANLOOKUPS; ++a) {
+	const Resource &key = keys.at(a);
+	for(const auto &resource: list) {
+	  if(resource.cacheId == key.cacheId && resource.type == key.type &&
+	     resource.source == key.source) {
+	    found++;
+	    break;
+	  }
+	}
+      }
+      scanTime = (double)timer.nsecsElapsed() / SCANLOOKUPS;
+    }
+
+    if(scanTime < 0) {
+      printf("%10d %18.1f %18s\n", count, storeTime, "-");
+    } else {
+      printf("%10d %18.1f %18.1f\n", count, storeTime, scanTime);
+    }
+    if(found < LOOKUPS) {
+      printf("Lookups failed, the benchmark is broken!\n");
+      return 1;
+    }
+  }
+  return 0;
+}
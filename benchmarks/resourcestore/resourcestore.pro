@@ -0,0 +1,13 @@
+# Standalone benchmark of the resource cache index. Build and run with:
+# qmake && make && ./resourcestore-benchmark
+TEMPLATE = app
+TARGET = resourcestore-benchmark
+CONFIG += console release
+CONFIG -= app_bundle
+QT = core
+QMAKE_CXXFLAGS += -std=c++11
+INCLUDEPATH += ../../src
+
+SOURCES += main.cpp \
+           ../../src/resourcestore.cpp
+HEADERS += ../../src/resourcestore.h
@@ -4,7 +4,7 @@ DEPENDPATH += .
 INCLUDEPATH += .
 CONFIG += release
 win32:CONFIG += console
-QT += core network xml
+QT += core network xml concurrent
 QMAKE_CXXFLAGS += -std=c++11
 
 unix:target.path=/usr/local/bin
@@ -27,6 +27,9 @@ unix:INSTALLS += target examples cacheexamples impexamples resexamples
 include(./VERSION)
 DEFINES+=VERSION=\\\"$$VERSION\\\"
 
+unix:LIBS += -lz
+unix:DEFINES += WITH_ZLIB
+
 HEADERS += src/skyscraper.h \
            src/netmanager.h \
            src/netcomm.h \
@@ -74,7 +77,18 @@ HEADERS += src/skyscraper.h \
            src/fxrotate.h \
            src/fxscanlines.h \
            src/nametools.h \
-           src/queue.h
+           src/queue.h \
+           src/resourcestore.h \
+           src/binarycache.h \
+           src/cachejournal.h \
+           src/ratelimiter.h \
+           src/httpcache.h \
+           src/retrypolicy.h \
+           src/stagequeue.h \
+           src/pipeline.h \
+           src/apibatcher.h \
+           src/filehasher.h \
+           src/zipreader.h
 
 SOURCES += src/main.cpp \
            src/skyscraper.cpp \
@@ -123,4 +137,15 @@ SOURCES += src/main.cpp \
            src/fxrotate.cpp \
            src/fxscanlines.cpp \
            src/nametools.cpp \
-           src/queue.cpp
+           src/queue.cpp \
+           src/resourcestore.cpp \
+           src/binarycache.cpp \
+           src/cachejournal.cpp \
+           src/ratelimiter.cpp \
+           src/httpcache.cpp \
+           src/retrypolicy.cpp \
+           src/stagequeue.cpp \
+           src/pipeline.cpp \
+           src/apibatcher.cpp \
+           src/filehasher.cpp \
+           src/zipreader.cpp
@@ -37,6 +37,10 @@ AbstractScraper::AbstractScraper(Settings *config,
 {
   netComm = new NetComm(manager);
   connect(netComm, &NetComm::dataReady, &q, &QEventLoop::quit);
+  if(config->httpCacheTtl > 0 && !config->cacheFolder.isEmpty()) {
+    netComm->setHttpCache(HttpCache::get(config->cacheFolder + "/http",
+					 config->httpCacheTtl, config->httpCacheSize));
+  }
 }
 
 AbstractScraper::~AbstractScraper()
@@ -135,6 +139,7 @@ void AbstractScraper::getGameData(GameEntry &game)
       ;
     }
   }
+  fetchMedia();
 }
 
 void AbstractScraper::getDescription(GameEntry &game)
@@ -291,13 +296,15 @@ void AbstractScraper::getCover(GameEntry &game)
   if(coverUrl.left(4) != "http") {
     coverUrl.prepend(baseUrl + (coverUrl.left(1) == "/"?"":"/"));
   }
-  netComm->request(coverUrl);
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.coverData = netComm->getData();
-  }
+  queueMedia({coverUrl}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.coverData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void AbstractScraper::getScreenshot(GameEntry &game)
@@ -317,13 +324,15 @@ void AbstractScraper::getScreenshot(GameEntry &game)
     if(screenshotUrl.left(4) != "http") {
       screenshotUrl.prepend(baseUrl + (screenshotUrl.left(1) == "/"?"":"/"));
     }
-    netComm->request(screenshotUrl);
-    q.exec();
-    QImage image;
-    if(netComm->getError() == QNetworkReply::NoError &&
-       image.loadFromData(netComm->getData())) {
-      game.screenshotData = netComm->getData();
-    }
+    queueMedia({screenshotUrl}, [&game](const NetResult &result) {
+	QImage image;
+	if(result.getError() == QNetworkReply::NoError &&
+	   image.loadFromData(result.getData())) {
+	  game.screenshotData = result.getData();
+	  return true;
+	}
+	return false;
+      });
   }
 }
 
@@ -344,13 +353,15 @@ void AbstractScraper::getWheel(GameEntry &game)
   if(wheelUrl.left(4) != "http") {
     wheelUrl.prepend(baseUrl + (wheelUrl.left(1) == "/"?"":"/"));
   }
-  netComm->request(wheelUrl);
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.wheelData = netComm->getData();
-  }
+  queueMedia({wheelUrl}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.wheelData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void AbstractScraper::getMarquee(GameEntry &game)
@@ -370,13 +381,15 @@ void AbstractScraper::getMarquee(GameEntry &game)
   if(marqueeUrl.left(4) != "http") {
     marqueeUrl.prepend(baseUrl + (marqueeUrl.left(1) == "/"?"":"/"));
   }
-  netComm->request(marqueeUrl);
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.marqueeData = netComm->getData();
-  }
+  queueMedia({marqueeUrl}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.marqueeData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void AbstractScraper::getVideo(GameEntry &game)
@@ -396,12 +409,96 @@ void AbstractScraper::getVideo(GameEntry &game)
   if(videoUrl.left(4) != "http") {
     videoUrl.prepend(baseUrl + (videoUrl.left(1) == "/"?"":"/"));
   }
-  netComm->request(videoUrl);
-  q.exec();
-  if(netComm->getError() == QNetworkReply::NoError) {
-    game.videoData = netComm->getData();
-    game.videoFormat = videoUrl.right(3);
+  queueMediaToFile({videoUrl}, [&game, videoUrl](const NetResult &result) {
+      if(result.getError() == QNetworkReply::NoError) {
+	game.videoTempFile = result.getFileName();
+	game.videoSize = result.getSize();
+	game.videoFormat = videoUrl.right(3);
+	return true;
+      }
+      return false;
+    });
+}
+
+void AbstractScraper::queueMedia(const QStringList &urls,
+				 const std::function<bool(const NetResult &)> &handler,
+				 const int &tries)
+{
+  if(urls.isEmpty()) {
+    return;
+  }
+  MediaRequest media;
+  media.urls = urls;
+  media.handler = handler;
+  media.tries = qMax(tries, 1);
+  mediaRequests.append(media);
+}
+
+void AbstractScraper::queueMediaToFile(const QStringList &urls,
+				       const std::function<bool(const NetResult &)> &handler,
+				       const int &tries)
+{
+  queueMedia(urls, handler, tries);
+  if(!urls.isEmpty()) {
+    mediaRequests.last().toFile = true;
+  }
+}
+
+void AbstractScraper::fetchMedia()
+{
+  if(mediaRequests.isEmpty()) {
+    return;
+  }
+  QEventLoop mediaLoop;
+  int pending = mediaRequests.length();
+  QList<int> toSend;
+  for(int a = 0; a < mediaRequests.length(); ++a) {
+    toSend.append(a);
+  }
+  while(pending > 0) {
+    // Replies finishing while a request waits on the rate limit may queue retries here
+    while(!toSend.isEmpty()) {
+      int a = toSend.takeFirst();
+      const MediaRequest &media = mediaRequests.at(a);
+      if(retryPolicy != nullptr) {
+	retryPolicy->waitForCircuit();
+	retryPolicy->backoff(media.attempt % media.tries);
+      }
+      auto handleResult = [this, a, &pending, &toSend, &mediaLoop](const NetResult &result) {
+	MediaRequest &media = mediaRequests[a];
+	bool handled = media.handler(result);
+	if(retryPolicy != nullptr) {
+	  if(result.getError() != QNetworkReply::NoError) {
+	    retryPolicy->record(result.getError());
+	  } else if(handled) {
+	    retryPolicy->succeeded();
+	  } else {
+	    retryPolicy->failed("InvalidContent", false);
+	  }
+	}
+	if(!handled && !result.getFileName().isEmpty()) {
+	  QFile::remove(result.getFileName());
+	}
+	if(handled || ++media.attempt >= media.tries * media.urls.length()) {
+	  pending--;
+	} else {
+	  toSend.append(a);
+	}
+	mediaLoop.quit();
+      };
+      // All requests share 'netComm' and are in flight at the same time
+      if(media.toFile) {
+	netComm->requestToFile(media.urls.at(media.attempt / media.tries), config->cacheFolder,
+			       config->videoSizeLimit, handleResult);
+      } else {
+	netComm->requestAsync(media.urls.at(media.attempt / media.tries), handleResult);
+      }
+    }
+    if(pending > 0) {
+      mediaLoop.exec();
+    }
   }
+  mediaRequests.clear();
 }
 
 void AbstractScraper::nomNom(const QString nom, bool including)
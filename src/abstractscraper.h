@@ -27,6 +27,9 @@
 #define ABSTRACTSCRAPER_H
 
 #include "netcomm.h"
+#include "ratelimiter.h"
+#include "retrypolicy.h"
+#include "apibatcher.h"
 #include "netmanager.h"
 #include "gameentry.h"
 #include "settings.h"
@@ -36,6 +39,8 @@
 #include <QFileInfo>
 #include <QSettings>
 
+#include <functional>
+
 class AbstractScraper : public QObject
 {
   Q_OBJECT
@@ -52,6 +57,9 @@ public:
   //void setConfig(Settings *config);
 
   int reqRemaining = -1;
+  RateLimiter *rateLimiter = nullptr; // Shared by all threads scraping with this module
+  RetryPolicy *retryPolicy = nullptr; // Same
+  ApiBatcher *batcher = nullptr; // Same, for modules that can look up several games at once
 
 protected:
   Settings *config;
@@ -79,6 +87,19 @@ protected:
 
   bool checkNom(const QString nom);
 
+  // Media downloads queued while going through 'fetchOrder' are sent together by
+  // 'fetchMedia' and joined once they have all finished. 'handler' validates and
+  // stores the data. Returning false retries the url up to 'tries' times before
+  // moving on to the next url in 'urls'
+  void queueMedia(const QStringList &urls, const std::function<bool(const NetResult &)> &handler,
+		  const int &tries = 1);
+  // Same as above, but the data is streamed to a temporary file in the cache
+  // folder, which is what 'result.getFileName()' points to in 'handler'. The file
+  // is removed again if 'handler' returns false
+  void queueMediaToFile(const QStringList &urls, const std::function<bool(const NetResult &)> &handler,
+			const int &tries = 1);
+  void fetchMedia();
+
   QList<int> fetchOrder;
 
   QByteArray data;
@@ -129,6 +150,17 @@ protected:
   NetComm *netComm;
   QEventLoop q; // Event loop for use when waiting for data from NetComm.
 
+private:
+  struct MediaRequest {
+    QStringList urls;
+    std::function<bool(const NetResult &)> handler;
+    int tries = 1;
+    int attempt = 0;
+    bool toFile = false;
+  };
+
+  QList<MediaRequest> mediaRequests;
+
 };
 
 #endif // ABSTRACTSCRAPER_H
@@ -0,0 +1,105 @@
+/***************************************************************************
+ *            apibatcher.cpp
+ *
+ *  Sat Oct 17 23:15:51 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QMutexLocker>
+#include <QElapsedTimer>
+
+#include "apibatcher.h"
+
+QMutex ApiBatcher::batchersMutex;
+QMap<QString, QSharedPointer<ApiBatcher> > ApiBatcher::batchers;
+
+ApiBatcher::ApiBatcher(const int &maxBatch, const int &window)
+  : maxBatch(qMax(maxBatch, 1)), window(window)
+{
+}
+
+ApiBatcher *ApiBatcher::get(const QString &module, const int &maxBatch, const int &window)
+{
+  QMutexLocker locker(&batchersMutex);
+  if(!batchers.contains(module)) {
+    batchers[module] = QSharedPointer<ApiBatcher>(new ApiBatcher(maxBatch, window));
+  }
+  return batchers[module].data();
+}
+
+QByteArray ApiBatcher::fetch(const QString &id,
+			     const std::function<QByteArray(const QStringList &ids)> &request)
+{
+  QMutexLocker locker(&mutex);
+  lookups++;
+  if(!openBatch.isNull()) {
+    // Join the batch being collected and wait for the thread sending it
+    QSharedPointer<Batch> batch = openBatch;
+    if(!batch->ids.contains(id)) {
+      batch->ids.append(id);
+    }
+    if(batch->ids.length() >= maxBatch) {
+      openBatch.clear();
+      batchFull.wakeAll();
+    }
+    while(!batch->done) {
+      batchDone.wait(&mutex);
+    }
+    return batch->data;
+  }
+
+  QSharedPointer<Batch> batch = QSharedPointer<Batch>(new Batch);
+  batch->ids.append(id);
+  if(maxBatch > 1) {
+    openBatch = batch;
+    QElapsedTimer timer;
+    timer.start();
+    while(openBatch == batch && timer.elapsed() < window) {
+      batchFull.wait(&mutex, window - timer.elapsed());
+    }
+    if(openBatch == batch) {
+      openBatch.clear();
+    }
+  }
+  requests++;
+  QStringList ids = batch->ids;
+  locker.unlock();
+
+  QByteArray data = request(ids);
+
+  locker.relock();
+  batch->data = data;
+  batch->done = true;
+  batchDone.wakeAll();
+  return data;
+}
+
+int ApiBatcher::getRequests()
+{
+  QMutexLocker locker(&mutex);
+  return requests;
+}
+
+int ApiBatcher::getLookups()
+{
+  QMutexLocker locker(&mutex);
+  return lookups;
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+ *            apibatcher.h
+ *
+ *  Sat Oct 17 23:15:51 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef APIBATCHER_H
+#define APIBATCHER_H
+
+#include <functional>
+
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QByteArray>
+
+// Process wide batching of game data lookups for modules whose api accepts a
+// list of ids. The first thread asking for an id opens a batch and waits up to
+// 'window' ms for other threads to add theirs, or until 'maxBatch' ids have
+// been collected. It then sends a single request for all of them, and every
+// thread in the batch gets the same response to pick its own game from.
+class ApiBatcher
+{
+public:
+  ApiBatcher(const int &maxBatch, const int &window);
+  static ApiBatcher *get(const QString &module, const int &maxBatch, const int &window);
+  // 'request' is only called by the thread that ends up sending the batch
+  QByteArray fetch(const QString &id,
+		   const std::function<QByteArray(const QStringList &ids)> &request);
+  int getRequests();
+  int getLookups();
+
+private:
+  struct Batch {
+    QStringList ids;
+    QByteArray data;
+    bool done = false;
+  };
+
+  QMutex mutex;
+  QWaitCondition batchFull;
+  QWaitCondition batchDone;
+  QSharedPointer<Batch> openBatch;
+  int maxBatch;
+  int window;
+  int requests = 0;
+  int lookups = 0;
+
+  static QMutex batchersMutex;
+  static QMap<QString, QSharedPointer<ApiBatcher> > batchers;
+};
+
+#endif // APIBATCHER_H
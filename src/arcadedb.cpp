@@ -129,6 +129,7 @@ void ArcadeDB::getGameData(GameEntry &game)
       ;
     }
   }
+  fetchMedia();
 }
 
 void ArcadeDB::getReleaseDate(GameEntry &game)
@@ -161,24 +162,25 @@ void ArcadeDB::getDescription(GameEntry &game)
 
 void ArcadeDB::getCover(GameEntry &game)
 {
+  QStringList coverUrls;
   for(const auto &key: jsonObj.keys()) {
     if(key == "url_image_flyer" ||
        key == "url_image_title") {
       if(jsonObj.value(key).toString().isEmpty()) {
 	continue;
       }
-      netComm->request(jsonObj.value(key).toString());
-      q.exec();
-      {
-	QImage image;
-	if(netComm->getError() == QNetworkReply::NoError &&
-	   image.loadFromData(netComm->getData())) {
-	  game.coverData = netComm->getData();
-	  return;
-	}
-      }
+      coverUrls.append(jsonObj.value(key).toString());
     }
   }
+  queueMedia(coverUrls, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.coverData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void ArcadeDB::getScreenshot(GameEntry &game)
@@ -187,24 +189,28 @@ void ArcadeDB::getScreenshot(GameEntry &game)
      jsonObj.value("url_image_ingame").toString().isEmpty()) {
     return;
   }
-  netComm->request(jsonObj.value("url_image_ingame").toString());
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.screenshotData = netComm->getData();
-  }
+  queueMedia({jsonObj.value("url_image_ingame").toString()}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.screenshotData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void ArcadeDB::getWheel(GameEntry &game)
 {
-  netComm->request("http://adb.arcadeitalia.net/media/mame.current/decals/" + jsonObj["game_name"].toString() + ".png");
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.wheelData = netComm->getData();
-  }
+  queueMedia({"http://adb.arcadeitalia.net/media/mame.current/decals/" + jsonObj["game_name"].toString() + ".png"}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.wheelData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void ArcadeDB::getMarquee(GameEntry &game)
@@ -213,13 +219,15 @@ void ArcadeDB::getMarquee(GameEntry &game)
      jsonObj.value("url_image_marquee").toString().isEmpty()) {
     return;
   }
-  netComm->request(jsonObj.value("url_image_marquee").toString());
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.marqueeData = netComm->getData();
-  }
+  queueMedia({jsonObj.value("url_image_marquee").toString()}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.marqueeData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void ArcadeDB::getVideo(GameEntry &game)
@@ -228,15 +236,16 @@ void ArcadeDB::getVideo(GameEntry &game)
      jsonObj.value("url_video_shortplay").toString().isEmpty()) {
     return;
   }
-  netComm->request(jsonObj.value("url_video_shortplay").toString());
-  q.exec();
-  game.videoData = netComm->getData();
-  if(netComm->getError() == QNetworkReply::NoError &&
-     game.videoData.length() > 4096) {
-    game.videoFormat = "mp4";
-  } else {
-    game.videoData = "";
-  }
+  queueMediaToFile({jsonObj.value("url_video_shortplay").toString()}, [&game](const NetResult &result) {
+      game.videoSize = result.getSize();
+      if(result.getError() == QNetworkReply::NoError &&
+	 result.getSize() > 4096) {
+	game.videoTempFile = result.getFileName();
+	game.videoFormat = "mp4";
+	return true;
+      }
+      return false;
+    });
 }
 
 QList<QString> ArcadeDB::getSearchNames(const QFileInfo &info)
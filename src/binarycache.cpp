@@ -0,0 +1,375 @@
+/***************************************************************************
+ *            binarycache.cpp
+ *
+ *  Sat Oct 17 22:51:21 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <QtEndian>
+#include <QVector>
+#include <QSaveFile>
+
+#include "binarycache.h"
+#include "filehasher.h"
+
+#define HEADERSIZE 32
+#define RESOURCEVERSION 1
+#define RESOURCERECORDSIZE 40
+// Version 2 added size, inode and digests. Version 1 files are rejected and
+// the quick ids are read from 'quickid.xml' instead
+#define QUICKIDVERSION 2
+#define QUICKIDRECORDSIZE 88
+
+BinaryCache::BinaryCache()
+{
+}
+
+BinaryCache::~BinaryCache()
+{
+  close();
+}
+
+bool BinaryCache::openResources(const QString &fileName)
+{
+  return open(fileName, "SKYR", RESOURCEVERSION, RESOURCERECORDSIZE);
+}
+
+bool BinaryCache::openQuickIds(const QString &fileName)
+{
+  return open(fileName, "SKYQ", QUICKIDVERSION, QUICKIDRECORDSIZE);
+}
+
+bool BinaryCache::open(const QString &fileName, const QByteArray &magic,
+		       const quint32 &expectedVersion, const quint32 &expectedRecordSize)
+{
+  close();
+  file.setFileName(fileName);
+  if(!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  size = file.size();
+  if(size < HEADERSIZE) {
+    close();
+    return false;
+  }
+  data = file.map(0, size);
+  if(data == nullptr) {
+    close();
+    return false;
+  }
+  if(memcmp(data, magic.constData(), 4) != 0 ||
+     qFromLittleEndian<quint32>(data + 4) != expectedVersion) {
+    close();
+    return false;
+  }
+  count = qFromLittleEndian<quint32>(data + 8);
+  recordSize = qFromLittleEndian<quint32>(data + 12);
+  stringsOffset = qFromLittleEndian<quint64>(data + 16);
+  stringsSize = qFromLittleEndian<quint64>(data + 24);
+  indexOffset = HEADERSIZE + (quint64)count * recordSize;
+  if(recordSize != expectedRecordSize ||
+     stringsOffset != indexOffset + (quint64)count * 4 ||
+     stringsOffset + stringsSize > (quint64)size) {
+    close();
+    return false;
+  }
+  // Lookups follow the index without further checks, so a corrupt index must
+  // never point outside the records
+  for(quint32 a = 0; a < count; ++a) {
+    if(qFromLittleEndian<quint32>(data + indexOffset + (quint64)a * 4) >= count) {
+      close();
+      return false;
+    }
+  }
+  return true;
+}
+
+void BinaryCache::close()
+{
+  if(data != nullptr) {
+    file.unmap(const_cast<uchar *>(data));
+    data = nullptr;
+  }
+  if(file.isOpen()) {
+    file.close();
+  }
+  size = 0;
+  count = 0;
+  recordSize = 0;
+  indexOffset = 0;
+  stringsOffset = 0;
+  stringsSize = 0;
+}
+
+bool BinaryCache::isOpen() const
+{
+  return data != nullptr;
+}
+
+int BinaryCache::length() const
+{
+  return count;
+}
+
+const uchar *BinaryCache::record(const int &record) const
+{
+  return data + HEADERSIZE + (quint64)record * recordSize;
+}
+
+QString BinaryCache::stringAt(const uchar *ref) const
+{
+  quint32 offset = qFromLittleEndian<quint32>(ref);
+  quint32 length = qFromLittleEndian<quint32>(ref + 4);
+  if((quint64)offset + length > stringsSize) {
+    return QString();
+  }
+  return QString::fromUtf8((const char *)data + stringsOffset + offset, length);
+}
+
+Resource BinaryCache::resourceAt(const int &record) const
+{
+  Resource resource;
+  const uchar *rec = this->record(record);
+  resource.cacheId = stringAt(rec);
+  resource.type = stringAt(rec + 8);
+  resource.source = stringAt(rec + 16);
+  resource.value = stringAt(rec + 24);
+  resource.timestamp = qFromLittleEndian<qint64>(rec + 32);
+  return resource;
+}
+
+QString BinaryCache::quickIdPathAt(const int &record) const
+{
+  return stringAt(this->record(record));
+}
+
+QuickId BinaryCache::quickIdAt(const int &record) const
+{
+  const uchar *rec = this->record(record);
+  QuickId quickId;
+  quickId.cacheId = stringAt(rec + 8);
+  quickId.timestamp = qFromLittleEndian<qint64>(rec + 16);
+  quickId.size = qFromLittleEndian<qint64>(rec + 24);
+  quickId.inode = qFromLittleEndian<quint64>(rec + 32);
+  quickId.digests = qFromLittleEndian<qint32>(rec + 40);
+  quickId.crc32 = qFromLittleEndian<quint32>(rec + 44);
+  if(quickId.digests & FileHasher::MD5) {
+    quickId.md5 = QByteArray((const char *)rec + 48, 16);
+  }
+  if(quickId.digests & FileHasher::SHA1) {
+    quickId.sha1 = QByteArray((const char *)rec + 64, 20);
+  }
+  return quickId;
+}
+
+int BinaryCache::compareKey(const int &record, const QByteArray &key) const
+{
+  const uchar *rec = this->record(record);
+  quint32 offset = qFromLittleEndian<quint32>(rec);
+  quint32 length = qFromLittleEndian<quint32>(rec + 4);
+  if((quint64)offset + length > stringsSize) {
+    length = 0;
+  }
+  int result = memcmp(data + stringsOffset + offset, key.constData(),
+		      qMin((int)length, key.size()));
+  if(result != 0) {
+    return result;
+  }
+  return (int)length - key.size();
+}
+
+// Returns the first position in the sorted index whose key is not less than 'key'
+int BinaryCache::lowerBound(const QByteArray &key) const
+{
+  int first = 0;
+  int last = count;
+  while(first < last) {
+    int middle = first + (last - first) / 2;
+    quint32 rec = qFromLittleEndian<quint32>(data + indexOffset + (quint64)middle * 4);
+    if(compareKey(rec, key) < 0) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return first;
+}
+
+QList<Resource> BinaryCache::resources(const QString &cacheId) const
+{
+  QList<Resource> matchingResources;
+  if(!isOpen()) {
+    return matchingResources;
+  }
+  QByteArray key = cacheId.toUtf8();
+  // Records sharing a key are indexed in file order, so insertion order is kept
+  for(int a = lowerBound(key); a < (int)count; ++a) {
+    quint32 rec = qFromLittleEndian<quint32>(data + indexOffset + (quint64)a * 4);
+    if(compareKey(rec, key) != 0) {
+      break;
+    }
+    matchingResources.append(resourceAt(rec));
+  }
+  return matchingResources;
+}
+
+bool BinaryCache::quickId(const QString &filePath, QuickId &quickId) const
+{
+  if(!isOpen()) {
+    return false;
+  }
+  QByteArray key = filePath.toUtf8();
+  int pos = lowerBound(key);
+  if(pos >= (int)count) {
+    return false;
+  }
+  quint32 rec = qFromLittleEndian<quint32>(data + indexOffset + (quint64)pos * 4);
+  if(compareKey(rec, key) != 0) {
+    return false;
+  }
+  quickId = quickIdAt(rec);
+  return true;
+}
+
+void BinaryCache::putRef(uchar *dst, QHash<QString, QPair<quint32, quint32> > &strings,
+			 QByteArray &stringTable, const QString &str)
+{
+  QHash<QString, QPair<quint32, quint32> >::const_iterator it = strings.constFind(str);
+  QPair<quint32, quint32> ref;
+  if(it != strings.constEnd()) {
+    ref = it.value();
+  } else {
+    QByteArray utf8 = str.toUtf8();
+    ref.first = stringTable.size();
+    ref.second = utf8.size();
+    stringTable.append(utf8);
+    strings[str] = ref;
+  }
+  qToLittleEndian<quint32>(ref.first, dst);
+  qToLittleEndian<quint32>(ref.second, dst + 4);
+}
+
+bool BinaryCache::writeResources(const QString &fileName, const QList<Resource> &resources)
+{
+  QHash<QString, QPair<quint32, quint32> > strings;
+  QByteArray stringTable;
+  QByteArray records(resources.length() * RESOURCERECORDSIZE, '\0');
+  QList<QByteArray> keys;
+  keys.reserve(resources.length());
+  uchar *rec = (uchar *)records.data();
+  for(const auto &resource: resources) {
+    putRef(rec, strings, stringTable, resource.cacheId);
+    putRef(rec + 8, strings, stringTable, resource.type);
+    putRef(rec + 16, strings, stringTable, resource.source);
+    putRef(rec + 24, strings, stringTable, resource.value);
+    qToLittleEndian<qint64>(resource.timestamp, rec + 32);
+    keys.append(resource.cacheId.toUtf8());
+    rec += RESOURCERECORDSIZE;
+  }
+  return writeFile(fileName, "SKYR", RESOURCEVERSION, resources.length(), RESOURCERECORDSIZE,
+		   records, stringTable, keys);
+}
+
+bool BinaryCache::writeQuickIds(const QString &fileName,
+				const QMap<QString, QuickId> &quickIds)
+{
+  QHash<QString, QPair<quint32, quint32> > strings;
+  QByteArray stringTable;
+  QByteArray records(quickIds.size() * QUICKIDRECORDSIZE, '\0');
+  QList<QByteArray> keys;
+  keys.reserve(quickIds.size());
+  uchar *rec = (uchar *)records.data();
+  for(QMap<QString, QuickId>::const_iterator it = quickIds.constBegin();
+      it != quickIds.constEnd(); ++it) {
+    const QuickId &quickId = it.value();
+    putRef(rec, strings, stringTable, it.key());
+    putRef(rec + 8, strings, stringTable, quickId.cacheId);
+    qToLittleEndian<qint64>(quickId.timestamp, rec + 16);
+    qToLittleEndian<qint64>(quickId.size, rec + 24);
+    qToLittleEndian<quint64>(quickId.inode, rec + 32);
+    int digests = 0;
+    if(quickId.digests & FileHasher::CRC32) {
+      qToLittleEndian<quint32>(quickId.crc32, rec + 44);
+      digests |= FileHasher::CRC32;
+    }
+    if(quickId.digests & FileHasher::MD5 && quickId.md5.size() == 16) {
+      memcpy(rec + 48, quickId.md5.constData(), 16);
+      digests |= FileHasher::MD5;
+    }
+    if(quickId.digests & FileHasher::SHA1 && quickId.sha1.size() == 20) {
+      memcpy(rec + 64, quickId.sha1.constData(), 20);
+      digests |= FileHasher::SHA1;
+    }
+    qToLittleEndian<qint32>(digests, rec + 40);
+    keys.append(it.key().toUtf8());
+    rec += QUICKIDRECORDSIZE;
+  }
+  return writeFile(fileName, "SKYQ", QUICKIDVERSION, quickIds.size(), QUICKIDRECORDSIZE,
+		   records, stringTable, keys);
+}
+
+bool BinaryCache::writeFile(const QString &fileName, const QByteArray &magic,
+			    const quint32 &version, const quint32 &recordCount, const quint32 &recordSize,
+			    const QByteArray &records, const QByteArray &stringTable,
+			    const QList<QByteArray> &keys)
+{
+  QVector<quint32> order(recordCount);
+  for(quint32 a = 0; a < recordCount; ++a) {
+    order[a] = a;
+  }
+  // Must sort bytewise the same way 'compareKey' compares them when looking up
+  std::stable_sort(order.begin(), order.end(), [&keys](quint32 a, quint32 b) {
+      const QByteArray &keyA = keys.at(a);
+      const QByteArray &keyB = keys.at(b);
+      int result = memcmp(keyA.constData(), keyB.constData(), qMin(keyA.size(), keyB.size()));
+      if(result != 0) {
+	return result < 0;
+      }
+      return keyA.size() < keyB.size();
+    });
+  QByteArray index(recordCount * 4, '\0');
+  for(quint32 a = 0; a < recordCount; ++a) {
+    qToLittleEndian<quint32>(order.at(a), (uchar *)index.data() + a * 4);
+  }
+
+  QByteArray header(HEADERSIZE, '\0');
+  uchar *head = (uchar *)header.data();
+  memcpy(head, magic.constData(), 4);
+  qToLittleEndian<quint32>(version, head + 4);
+  qToLittleEndian<quint32>(recordCount, head + 8);
+  qToLittleEndian<quint32>(recordSize, head + 12);
+  qToLittleEndian<quint64>(HEADERSIZE + (quint64)records.size() + index.size(), head + 16);
+  qToLittleEndian<quint64>(stringTable.size(), head + 24);
+
+  // QSaveFile writes to a temporary file and only replaces the old one on commit
+  QSaveFile saveFile(fileName);
+  if(!saveFile.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  saveFile.write(header);
+  saveFile.write(records);
+  saveFile.write(index);
+  saveFile.write(stringTable);
+  return saveFile.commit();
+}
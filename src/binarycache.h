@@ -0,0 +1,90 @@
+/***************************************************************************
+ *            binarycache.h
+ *
+ *  Sat Oct 17 22:51:21 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef BINARYCACHE_H
+#define BINARYCACHE_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QHash>
+
+#include "resourcestore.h"
+
+// Binary counterpart of 'db.xml' and 'quickid.xml'. The file is a 32 byte
+// header followed by fixed width records, an index of the records sorted by
+// their key (cache id or file path) and a table of deduplicated UTF-8
+// strings. It is memory mapped read-only and records are only decoded when
+// they are looked up, so opening it only costs a single pass over the index.
+class BinaryCache
+{
+public:
+  BinaryCache();
+  ~BinaryCache();
+  bool openResources(const QString &fileName);
+  bool openQuickIds(const QString &fileName);
+  void close();
+  bool isOpen() const;
+  int length() const;
+  Resource resourceAt(const int &record) const;
+  QList<Resource> resources(const QString &cacheId) const;
+  QString quickIdPathAt(const int &record) const;
+  QuickId quickIdAt(const int &record) const;
+  bool quickId(const QString &filePath, QuickId &quickId) const;
+
+  static bool writeResources(const QString &fileName, const QList<Resource> &resources);
+  static bool writeQuickIds(const QString &fileName,
+			    const QMap<QString, QuickId> &quickIds);
+
+private:
+  QFile file;
+  const uchar *data = nullptr;
+  qint64 size = 0;
+  quint32 count = 0;
+  quint32 recordSize = 0;
+  quint64 indexOffset = 0;
+  quint64 stringsOffset = 0;
+  quint64 stringsSize = 0;
+
+  bool open(const QString &fileName, const QByteArray &magic, const quint32 &expectedVersion,
+	    const quint32 &expectedRecordSize);
+  const uchar *record(const int &record) const;
+  QString stringAt(const uchar *ref) const;
+  int compareKey(const int &record, const QByteArray &key) const;
+  int lowerBound(const QByteArray &key) const;
+
+  static void putRef(uchar *dst, QHash<QString, QPair<quint32, quint32> > &strings,
+		     QByteArray &stringTable, const QString &str);
+  static bool writeFile(const QString &fileName, const QByteArray &magic,
+			const quint32 &version,
+			const quint32 &recordCount, const quint32 &recordSize,
+			const QByteArray &records, const QByteArray &stringTable,
+			const QList<QByteArray> &keys);
+};
+
+#endif // BINARYCACHE_H
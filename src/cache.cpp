@@ -25,6 +25,20 @@
 
 #include <iostream>
 
+#include <QtGlobal>
+
+// Includes for Linux and MacOS
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Includes for Linux
+#if defined(Q_OS_LINUX)
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 #include <QFile>
 #include <QDir>
 #include <QXmlStreamReader>
@@ -33,15 +47,78 @@
 #include <QDomDocument>
 #include <QRegularExpression>
 #include <QBuffer>
+#include <QImageReader>
 #include <QProcess>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QtConcurrent>
 
 #include "cache.h"
 #include "nametools.h"
 #include "queue.h"
 
+EncodeJob::EncodeJob(Cache *cache, const Resource &resource, const QByteArray &imageData,
+		     const QString &cacheFile, const Settings &config)
+{
+  this->cache = cache;
+  this->resource = resource;
+  pendingKey = resource.cacheId + "/" + resource.type + "/" + resource.source;
+  this->imageData = imageData;
+  this->cacheFile = cacheFile;
+  cacheResize = config.cacheResize;
+  jpgQuality = config.jpgQuality;
+  verbosity = config.verbosity;
+  refresh = config.refresh;
+}
+
+void EncodeJob::run()
+{
+  bool okToAppend = cache->encodeImage(resource, imageData, cacheFile,
+				       cacheResize, jpgQuality, verbosity);
+  imageData.clear();
+  // 'Cache::addResource' waits for a slot while holding an id mutex, so the
+  // slot must be freed before taking one here
+  cache->encodeSlots.release();
+  // Same cache id ordering as in 'Cache::addResource'
+  int bucket = qHash(resource.cacheId) % Cache::idMutexCount;
+  QMutex &idMutex = cache->idMutexes[bucket];
+  cache->lockMutex(idMutex);
+  cache->commitResource(resource, okToAppend, refresh);
+  cache->pendingEncodes[bucket].remove(pendingKey);
+  idMutex.unlock();
+}
+
+MediaCheckThread::MediaCheckThread(Cache *cache)
+{
+  this->cache = cache;
+}
+
+void MediaCheckThread::run()
+{
+  cache->checkAllMedia();
+}
+
 Cache::Cache(const QString &cacheFolder)
 {
   cacheDir = QDir(cacheFolder);
+  // The queue holds at most a couple of images per encoding thread
+  encodePool.setMaxThreadCount(QThread::idealThreadCount());
+  encodeSlots.release(encodePool.maxThreadCount() * 2);
+}
+
+Cache::~Cache()
+{
+  waitForEncodes();
+  stopMediaCheck();
+}
+
+void Cache::setConfig(const Settings &config)
+{
+  cacheFormat = config.cacheFormat;
+  journalLimit = config.cacheJournalLimit;
+  mediaCheck = config.cacheMediaCheck;
+  dedupMedia = config.cacheDedup;
 }
 
 bool Cache::createFolders(const QString &scraper)
@@ -74,6 +151,101 @@ bool Cache::createFolders(const QString &scraper)
 }
 
 bool Cache::read()
+{
+  if(binaryIsNewer("quickid")) {
+    printf("Mapping binary quick id cache, please wait... ");
+    fflush(stdout);
+    if(binQuickIds.openQuickIds(cacheDir.absolutePath() + "/quickid.bin")) {
+      printf("\033[1;32mDone!\033[0m\n");
+    } else {
+      printf("\033[1;31mFailed!\033[0m Falling back to 'quickid.xml'...\n");
+      readQuickIdXml();
+    }
+  } else {
+    readQuickIdXml();
+  }
+
+  bool result = false;
+  if(binaryIsNewer("db")) {
+    printf("Mapping binary resource cache, please wait... ");
+    fflush(stdout);
+    if(binResources.openResources(cacheDir.absolutePath() + "/db.bin")) {
+      resAtLoad = binResources.length();
+      // Media files are never checked when mapping, so check them once they are used
+      lazyMediaCheck = true;
+      printf("\033[1;32mDone!\033[0m\n");
+      printf("Successfully mapped %d resources!\n\n", resAtLoad);
+      result = true;
+    } else {
+      printf("\033[1;31mFailed!\033[0m Falling back to 'db.xml'...\n");
+    }
+  }
+  if(!result) {
+    lazyMediaCheck = (mediaCheck != "startup");
+    result = readResourceXml();
+  }
+  if(readJournal()) {
+    result = true;
+  }
+  return result;
+}
+
+// Replays changes that were journaled but never made it into the main cache
+// files, for instance because the previous run was interrupted. This is also
+// done when the journal has since been disabled, otherwise its records would
+// be replayed over newer data once it is enabled again
+bool Cache::readJournal()
+{
+  QList<Resource> journalResources;
+  QList<Resource> journalRemovals;
+  QMap<QString, QuickId> journalQuickIds;
+  if(journalLimit > 0) {
+    if(!journal.open(cacheDir.absolutePath() + "/db.journal",
+		     journalResources, journalRemovals, journalQuickIds)) {
+      printf("\033[1;33mCouldn't open cache journal, new resources will only be saved at the end of the run!\033[0m\n\n");
+      return false;
+    }
+  } else if(!QFileInfo::exists(cacheDir.absolutePath() + "/db.journal") ||
+	    !CacheJournal::read(cacheDir.absolutePath() + "/db.journal",
+				journalResources, journalRemovals, journalQuickIds)) {
+    return false;
+  }
+  if(journalResources.isEmpty() && journalRemovals.isEmpty() && journalQuickIds.isEmpty()) {
+    return false;
+  }
+  for(const auto &removal: journalRemovals) {
+    loadResources(removal.cacheId);
+    resources.remove(removal.cacheId, removal.type, removal.source);
+  }
+  for(const auto &resource: journalResources) {
+    loadResources(resource.cacheId);
+    resources.append(resource);
+  }
+  for(QMap<QString, QuickId>::const_iterator it = journalQuickIds.constBegin();
+      it != journalQuickIds.constEnd(); ++it) {
+    quickIds[it.key()] = it.value();
+  }
+  printf("Replayed %d resources, %d removals and %d quick ids from cache journal!\n\n",
+	 journalResources.length(), journalRemovals.length(), journalQuickIds.size());
+  return !journalResources.isEmpty() || !journalRemovals.isEmpty();
+}
+
+// Returns true if the binary version of 'db' or 'quickid' should be used. It
+// is used if it's the only one that exists or if it's the most recently written
+bool Cache::binaryIsNewer(const QString &baseName)
+{
+  QFileInfo binInfo(cacheDir.absolutePath() + "/" + baseName + ".bin");
+  QFileInfo xmlInfo(cacheDir.absolutePath() + "/" + baseName + ".xml");
+  if(!binInfo.exists()) {
+    return false;
+  }
+  if(!xmlInfo.exists()) {
+    return true;
+  }
+  return binInfo.lastModified() >= xmlInfo.lastModified();
+}
+
+bool Cache::readQuickIdXml()
 {
   QFile quickIdFile(cacheDir.absolutePath() + "/quickid.xml");
   if(quickIdFile.open(QIODevice::ReadOnly)) {
@@ -94,18 +266,69 @@ bool Cache::read()
 	continue;
       }
 
-      QPair<qint64, QString> pair;
-      pair.first = attribs.value("timestamp").toULongLong();
-      pair.second = attribs.value("id").toString();
-      quickIds[attribs.value("filepath").toString()] = pair;
+      QuickId quickId;
+      quickId.timestamp = attribs.value("timestamp").toULongLong();
+      quickId.cacheId = attribs.value("id").toString();
+      if(attribs.hasAttribute("size")) {
+	quickId.size = attribs.value("size").toLongLong();
+      }
+      if(attribs.hasAttribute("inode")) {
+	quickId.inode = attribs.value("inode").toULongLong();
+      }
+      if(attribs.hasAttribute("crc32")) {
+	quickId.crc32 = attribs.value("crc32").toUInt(nullptr, 16);
+	quickId.digests |= FileHasher::CRC32;
+      }
+      if(attribs.hasAttribute("md5")) {
+	quickId.md5 = QByteArray::fromHex(attribs.value("md5").toLatin1());
+	quickId.digests |= FileHasher::MD5;
+      }
+      if(attribs.hasAttribute("sha1")) {
+	quickId.sha1 = QByteArray::fromHex(attribs.value("sha1").toLatin1());
+	quickId.digests |= FileHasher::SHA1;
+      }
+      quickIds[attribs.value("filepath").toString()] = quickId;
     }
     printf("\033[1;32mDone!\033[0m\n");
+    return true;
+  }
+  return false;
+}
+
+bool Cache::readResourceXml()
+{
+  if(!QFileInfo::exists(cacheDir.absolutePath() + "/db.xml")) {
+    return false;
+  }
+  printf("Reading and parsing resource cache, please wait... ");
+  fflush(stdout);
+  bool result = parseResourceXml([this](const Resource &resource) {
+      if(!lazyMediaCheck && (resource.type == "cover" || resource.type == "screenshot" ||
+			     resource.type == "wheel" || resource.type == "marquee" ||
+			     resource.type == "video")) {
+	if(!QFileInfo::exists(cacheDir.absolutePath() + "/" + resource.value)) {
+	  printf("Source file '%s' missing, skipping entry...\n",
+		 resource.value.toStdString().c_str());
+	  return;
+	}
+      }
+      resources.append(resource);
+    });
+  if(!result) {
+    printf("\033[1;31mFailed!\033[0m\n\n");
+    return false;
   }
+  resAtLoad = resources.length();
+  printf("\033[1;32mDone!\033[0m\n");
+  printf("Successfully parsed %d resources!\n\n", resources.length());
+  return true;
+}
 
+// Hands each resource in 'db.xml' to 'handle' as it is parsed
+bool Cache::parseResourceXml(const std::function<void(const Resource &)> &handle)
+{
   QFile cacheFile(cacheDir.absolutePath() + "/db.xml");
   if(cacheFile.open(QIODevice::ReadOnly)) {
-    printf("Reading and parsing resource cache, please wait... ");
-    fflush(stdout);
     QXmlStreamReader xml(&cacheFile);
     while(!xml.atEnd()) {
       if(xml.readNext() != QXmlStreamReader::StartElement) {
@@ -134,7 +357,6 @@ bool Cache::read()
       }
       if(attribs.hasAttribute("type")) {
 	resource.type = attribs.value("type").toString();
-	addToResCounts(resource.source, resource.type);
       } else {
 	printf("Resource with cache id '%s' is missing 'type' attribute, skipping...\n",
 	       resource.cacheId.toStdString().c_str());
@@ -148,27 +370,107 @@ bool Cache::read()
 	continue;
       }
       resource.value = xml.readElementText();
-      if(resource.type == "cover" || resource.type == "screenshot" ||
-	 resource.type == "wheel" || resource.type == "marquee" ||
-	 resource.type == "video") {
-	if(!QFileInfo::exists(cacheDir.absolutePath() + "/" + resource.value)) {
-	  printf("Source file '%s' missing, skipping entry...\n",
-		 resource.value.toStdString().c_str());
-	  continue;
-	}
-      }
-
-      resources.append(resource);
+      handle(resource);
     }
     cacheFile.close();
-    resAtLoad = resources.length();
-    printf("\033[1;32mDone!\033[0m\n");
-    printf("Successfully parsed %d resources!\n\n", resources.length());
     return true;
   }
   return false;
 }
 
+// Moves the mapped resources for a single cache id into 'resources'. From then
+// on 'resources' is the only authority for that id. Caller must hold 'cacheLock'
+// for writing
+void Cache::loadResources(const QString &cacheId)
+{
+  if(!binResources.isOpen() || binLoadedIds.contains(cacheId)) {
+    return;
+  }
+  binLoadedIds.insert(cacheId);
+  for(const auto &resource: binResources.resources(cacheId)) {
+    resources.append(resource);
+  }
+}
+
+// Same as above, but for the scraping threads. Takes 'cacheLock' for writing
+// only if the cache id hasn't been loaded yet
+void Cache::ensureLoaded(const QString &cacheId)
+{
+  lockForRead();
+  bool loaded = (!binResources.isOpen() || binLoadedIds.contains(cacheId));
+  cacheLock.unlock();
+  if(!loaded) {
+    lockForWrite();
+    loadResources(cacheId);
+    cacheLock.unlock();
+  }
+}
+
+// The lock functions below count how often a thread had to wait for another
+void Cache::lockForRead()
+{
+  if(!cacheLock.tryLockForRead()) {
+    lockWaits.fetchAndAddRelaxed(1);
+    cacheLock.lockForRead();
+  }
+}
+
+void Cache::lockForWrite()
+{
+  if(!cacheLock.tryLockForWrite()) {
+    lockWaits.fetchAndAddRelaxed(1);
+    cacheLock.lockForWrite();
+  }
+}
+
+void Cache::lockMutex(QMutex &mutex)
+{
+  if(!mutex.tryLock()) {
+    lockWaits.fetchAndAddRelaxed(1);
+    mutex.lock();
+  }
+}
+
+int Cache::getLockWaits()
+{
+  return lockWaits.load();
+}
+
+// Decodes the entire mapped 'db.bin' for operations that work on all resources
+void Cache::loadAllResources()
+{
+  if(!binResources.isOpen()) {
+    return;
+  }
+  ResourceStore allResources;
+  for(int a = 0; a < binResources.length(); ++a) {
+    Resource resource = binResources.resourceAt(a);
+    if(!binLoadedIds.contains(resource.cacheId)) {
+      allResources.append(resource);
+    }
+  }
+  for(const auto &resource: resources.toList()) {
+    allResources.append(resource);
+  }
+  resources = allResources;
+  binResources.close();
+  binLoadedIds.clear();
+}
+
+void Cache::loadAllQuickIds()
+{
+  if(!binQuickIds.isOpen()) {
+    return;
+  }
+  for(int a = 0; a < binQuickIds.length(); ++a) {
+    QString filePath = binQuickIds.quickIdPathAt(a);
+    if(!quickIds.contains(filePath)) {
+      quickIds[filePath] = binQuickIds.quickIdAt(a);
+    }
+  }
+  binQuickIds.close();
+}
+
 void Cache::printPriorities(QString cacheId)
 {
   GameEntry game;
@@ -266,13 +568,14 @@ void Cache::editResources(QSharedPointer<Queue> queue,
 
   int queueLength = queue->length();
   printf("\033[1;33mEntering resource cache editing mode! This mode allows you to edit textual resources for your files. To add media resources use the 'import' scraping module instead.\nNote that you can provide one or more file names on command line to edit resources for just those specific files. You can also use the '--startat' and '--endat' command line options to narrow down the span of the roms you wish to edit. Otherwise Skyscraper will edit ALL files found in the input folder one by one.\033[0m\n\n");
-  while(queue->hasEntry()) {
-    QFileInfo info = queue->takeEntry();
+  QFileInfo info;
+  while(queue->takeEntry(info)) {
     QString cacheId = getQuickId(info);
     if(cacheId.isEmpty()) {
       cacheId = NameTools::getCacheId(info);
       addQuickId(info, cacheId);
     }
+    loadResources(cacheId);
     bool doneEdit = false;
     printPriorities(cacheId);
     while(!doneEdit) {
@@ -308,14 +611,12 @@ void Cache::editResources(QSharedPointer<Queue> queue,
       } else if(userInput == "S") {
 	printf("\033[1;34mResources connected to this rom:\033[0m\n");
 	bool found = false;
-	for(const auto &res: resources) {
-	  if(res.cacheId == cacheId) {
-	    printf("\033[1;33m%s\033[0m (%s): '\033[1;32m%s\033[0m'\n",
-		   res.type.toStdString().c_str(),
-		   res.source.toStdString().c_str(),
-		   res.value.toStdString().c_str());
-	    found = true;
-	  }
+	for(const auto &res: resources.values(cacheId)) {
+	  printf("\033[1;33m%s\033[0m (%s): '\033[1;32m%s\033[0m'\n",
+		 res.type.toStdString().c_str(),
+		 res.source.toStdString().c_str(),
+		 res.value.toStdString().c_str());
+	  found = true;
 	}
 	if(!found)
 	  printf("None\n");
@@ -439,17 +740,8 @@ void Cache::editResources(QSharedPointer<Queue> queue,
 	    continue;
 	  } else if(!value.isEmpty() && QRegularExpression(expression).match(value).hasMatch()) {
 	    newRes.value = value;
-	    bool updated = false;
-	    QMutableListIterator<Resource> it(resources);
-	    while(it.hasNext()) {
-	      Resource res = it.next();
-	      if(res.cacheId == newRes.cacheId &&
-		 res.type == newRes.type &&
-		 res.source == newRes.source) {
-		it.remove();
-		updated = true;
-	      }
-	    }
+	    // Appending replaces any existing resource with the same type and source
+	    bool updated = resources.contains(newRes.cacheId, newRes.type, newRes.source);
 	    resources.append(newRes);
 	    if(updated) {
 	      printf(">>> Updated existing ");
@@ -465,19 +757,18 @@ void Cache::editResources(QSharedPointer<Queue> queue,
 	}
       } else if(userInput == "d") {
 	int b = 1;
-	QList<int> resIds;
+	QList<Resource> resList;
 	printf("\033[1;34mWhich resource id would you like to remove?\033[0m (Enter to cancel)\n");
-	for(int a = 0; a < resources.length(); ++a) {
-	  if(resources.at(a).cacheId == cacheId &&
-	     resources.at(a).type != "screenshot" &&
-	     resources.at(a).type != "cover" &&
-	     resources.at(a).type != "wheel" &&
-	     resources.at(a).type != "marquee" &&
-	     resources.at(a).type != "video") {
-	    printf("\033[1;33m%d\033[0m) \033[1;33m%s\033[0m (%s): '\033[1;32m%s\033[0m'\n", b, resources.at(a).type.toStdString().c_str(),
-		   resources.at(a).source.toStdString().c_str(),
-		   resources.at(a).value.toStdString().c_str());
-	    resIds.append(a);
+	for(const auto &res: resources.values(cacheId)) {
+	  if(res.type != "screenshot" &&
+	     res.type != "cover" &&
+	     res.type != "wheel" &&
+	     res.type != "marquee" &&
+	     res.type != "video") {
+	    printf("\033[1;33m%d\033[0m) \033[1;33m%s\033[0m (%s): '\033[1;32m%s\033[0m'\n", b, res.type.toStdString().c_str(),
+		   res.source.toStdString().c_str(),
+		   res.value.toStdString().c_str());
+	    resList.append(res);
 	    b++;
 	  }
 	}
@@ -494,25 +785,22 @@ void Cache::editResources(QSharedPointer<Queue> queue,
 	  continue;
 	} else {
 	  int chosen = atoi(typeInput.c_str());
-	  if(chosen >= 1 && chosen <= resIds.length()) {
-	    resources.removeAt(resIds.at(chosen - 1)); // -1 because lists start at 0
+	  if(chosen >= 1 && chosen <= resList.length()) {
+	    const Resource &res = resList.at(chosen - 1); // -1 because lists start at 0
+	    resources.remove(res.cacheId, res.type, res.source);
 	    printf("<<< Removed resource id %d\n\n", chosen);
 	  } else {
 	    printf("Incorrect resource id, cancelling...\n\n");
 	  }
 	}
       } else if(userInput == "D") {
-	QMutableListIterator<Resource> it(resources);
 	bool found = false;
-	while(it.hasNext()) {
-	  Resource res = it.next();
-	  if(res.cacheId == cacheId) {
-	    printf("<<< Removed \033[1;33m%s\033[0m (%s) with value '\033[1;32m%s\033[0m'\n", res.type.toStdString().c_str(),
-		   res.source.toStdString().c_str(),
-		   res.value.toStdString().c_str());
-	    it.remove();
-	    found = true;
-	  }
+	for(const auto &res: resources.values(cacheId)) {
+	  printf("<<< Removed \033[1;33m%s\033[0m (%s) with value '\033[1;32m%s\033[0m'\n", res.type.toStdString().c_str(),
+		 res.source.toStdString().c_str(),
+		 res.value.toStdString().c_str());
+	  resources.remove(res.cacheId, res.type, res.source);
+	  found = true;
 	}
 	if(!found)
 	  printf("No resources found for this rom...\n");
@@ -520,10 +808,8 @@ void Cache::editResources(QSharedPointer<Queue> queue,
       } else if(userInput == "m") {
 	printf("\033[1;34mResources from which module would you like to remove?\033[0m (Enter to cancel)\n");
 	QMap<QString, int> modules;
-	for(const auto &res: resources) {
-	  if(res.cacheId == cacheId) {
-	    modules[res.source] += 1;
-	  }
+	for(const auto &res: resources.values(cacheId)) {
+	  modules[res.source] += 1;
 	}
 	QMap<QString, int>::iterator it;
 	for(it = modules.begin(); it != modules.end(); ++it) {
@@ -541,12 +827,10 @@ void Cache::editResources(QSharedPointer<Queue> queue,
 	  printf("Resource removal cancelled...\n\n");
 	  continue;
 	} else if(modules.contains(QString(typeInput.c_str()))) {
-	  QMutableListIterator<Resource> it(resources);
 	  int removed = 0;
-	  while(it.hasNext()) {
-	    Resource res = it.next();
-	    if(res.cacheId == cacheId && res.source == QString(typeInput.c_str())) {
-	      it.remove();
+	  for(const auto &res: resources.values(cacheId)) {
+	    if(res.source == QString(typeInput.c_str())) {
+	      resources.remove(res.cacheId, res.type, res.source);
 	      removed++;
 	    }
 	  }
@@ -558,10 +842,8 @@ void Cache::editResources(QSharedPointer<Queue> queue,
       } else if(userInput == "t") {
 	printf("\033[1;34mResources of which type would you like to remove?\033[0m (Enter to cancel)\n");
 	QMap<QString, int> types;
-	for(const auto &res: resources) {
-	  if(res.cacheId == cacheId) {
-	    types[res.type] += 1;
-	  }
+	for(const auto &res: resources.values(cacheId)) {
+	  types[res.type] += 1;
 	}
 	QMap<QString, int>::iterator it;
 	for(it = types.begin(); it != types.end(); ++it) {
@@ -579,12 +861,10 @@ void Cache::editResources(QSharedPointer<Queue> queue,
 	  printf("Resource removal cancelled...\n\n");
 	  continue;
 	} else if(types.contains(QString(typeInput.c_str()))) {
-	  QMutableListIterator<Resource> it(resources);
 	  int removed = 0;
-	  while(it.hasNext()) {
-	    Resource res = it.next();
-	    if(res.cacheId == cacheId && res.type == QString(typeInput.c_str())) {
-	      it.remove();
+	  for(const auto &res: resources.values(cacheId)) {
+	    if(res.type == QString(typeInput.c_str())) {
+	      resources.remove(res.cacheId, res.type, res.source);
 	      removed++;
 	    }
 	  }
@@ -596,7 +876,7 @@ void Cache::editResources(QSharedPointer<Queue> queue,
 	printf("Exiting without saving changes.\n");
 	exit(0);
       } else if(userInput == "q") {
-	queue->clear();
+	queue->clearAll();
 	doneEdit = true;
 	continue;
       }
@@ -626,9 +906,8 @@ bool Cache::purgeResources(QString purgeStr)
 
   int purged = 0;
 
-  QMutableListIterator<Resource> it(resources);
-  while(it.hasNext()) {
-    Resource res = it.next();
+  loadAllResources();
+  for(const auto &res: resources.toList()) {
     bool remove = false;
     if(res.source == module || res.type == type) {
       remove = true;
@@ -637,12 +916,12 @@ bool Cache::purgeResources(QString purgeStr)
       if(res.type == "cover" || res.type == "screenshot" ||
 	 res.type == "wheel" || res.type == "marquee" ||
 	 res.type == "video") {
-	if(!QFile::remove(cacheDir.absolutePath() + "/" + res.value)) {
+	if(!removeMediaFile(res.value)) {
 	  printf("Couldn't purge media file '%s', skipping...\n", res.value.toStdString().c_str());
 	  continue;
 	}
       }
-      it.remove();
+      resources.remove(res.cacheId, res.type, res.source);
       purged++;
     }
   }
@@ -665,28 +944,28 @@ bool Cache::purgeAll(const bool unattend)
 
   printf("Purging ALL resources for the selected platform, please wait...");
 
+  loadAllResources();
+
   int purged = 0;
   int dots = 0;
   // Always make dotMod at least 1 or it will give "floating point exception" when modulo
-  int dotMod = resources.size() * 0.1 + 1;
+  int dotMod = resources.length() * 0.1 + 1;
 
-  QMutableListIterator<Resource> it(resources);
-  while(it.hasNext()) {
+  for(const auto &res: resources.toList()) {
     if(dots % dotMod == 0) {
       printf(".");
       fflush(stdout);
     }
     dots++;
-    Resource res = it.next();
     if(res.type == "cover" || res.type == "screenshot" ||
        res.type == "wheel" || res.type == "marquee" ||
        res.type == "video") {
-      if(!QFile::remove(cacheDir.absolutePath() + "/" + res.value)) {
+      if(!removeMediaFile(res.value)) {
 	printf("Couldn't purge media file '%s', skipping...\n", res.value.toStdString().c_str());
 	continue;
       }
     }
-    it.remove();
+    resources.remove(res.cacheId, res.type, res.source);
     purged++;
   }
   printf("\033[1;32m Done!\033[0m\n");
@@ -724,24 +1003,41 @@ QList<QFileInfo> Cache::getFileInfos(const QString &inputFolder, const QString &
 
 QList<QString> Cache::getCacheIdList(const QList<QFileInfo> &fileInfos)
 {
-  QList<QString> cacheIdList;
+  // Each file is handled by its own task, the results keep the order of 'fileInfos'
+  QVector<QString> cacheIds(fileInfos.size());
+  QVector<int> fileIndexes(fileInfos.size());
+  for(int a = 0; a < fileIndexes.size(); ++a) {
+    fileIndexes[a] = a;
+  }
+  QString *ids = cacheIds.data();
+  QAtomicInt filesDone;
+  QElapsedTimer idTimer;
+  idTimer.start();
+  QFuture<void> future = QtConcurrent::map(fileIndexes, [&](const int &a) {
+      QString cacheId = getQuickId(fileInfos.at(a));
+      if(cacheId.isEmpty()) {
+	cacheId = NameTools::getCacheId(fileInfos.at(a));
+	addQuickId(fileInfos.at(a), cacheId);
+      }
+      ids[a] = cacheId;
+      filesDone.fetchAndAddRelaxed(1);
+    });
   int dots = 0;
-  // Always make dotMod at least 1 or it will give "floating point exception" when modulo
-  int dotMod = fileInfos.size() * 0.1 + 1;
-  for(const auto &info: fileInfos) {
-    if(dots % dotMod == 0) {
+  while(!future.isFinished()) {
+    // Always make the divisor at least 1 or it will give "floating point exception"
+    while(dots < 10 && filesDone.load() >= (fileInfos.size() / 10 + 1) * dots) {
       printf(".");
       fflush(stdout);
+      dots++;
     }
-    dots++;
-    QString cacheId = getQuickId(info);
-    if(cacheId.isEmpty()) {
-      cacheId = NameTools::getCacheId(info);
-      addQuickId(info, cacheId);
-    }
-    cacheIdList.append(cacheId);
+    QThread::msleep(100);
   }
-  return cacheIdList;
+  future.waitForFinished();
+  qint64 elapsed = idTimer.elapsed();
+  printf(" %d files at %d files/s", fileInfos.size(),
+	 (int)(fileInfos.size() * 1000 / (elapsed > 0?elapsed:1)));
+  fflush(stdout);
+  return cacheIds.toList();
 }
 
 void Cache::assembleReport(const Settings &config, const QString filter)
@@ -885,6 +1181,7 @@ void Cache::assembleReport(const Settings &config, const QString filter)
     return;
   }
 
+  loadAllResources();
   QString dateTime = QDateTime::currentDateTime().toString("yyyyMMdd");
   for(const auto &resType: resTypeList) {
     QFile reportFile(reportsDir.absolutePath() + "/report-" + config.platform + "-missing_" + resType + "-" + dateTime + ".txt");
@@ -901,16 +1198,7 @@ void Cache::assembleReport(const Settings &config, const QString filter)
 	  fflush(stdout);
 	}
 	dots++;
-	bool found = false;
-	for(const auto &res: resources) {
-	  if(res.cacheId == cacheIdList.at(a)) {
-	    if(res.type == resType) {
-	      found = true;
-	      break;
-	    }
-	  }
-	}
-	if(!found) {
+	if(!resources.containsType(cacheIdList.at(a), resType)) {
 	  missing++;
 	  reportFile.write(fileInfos.at(a).absoluteFilePath().toUtf8() + "\n");
 	}
@@ -941,8 +1229,10 @@ bool Cache::vacuumResources(const QString inputFolder, const QString filter,
 
   printf("Vacuuming cache, this can take several minutes, please wait...");
   QList<QFileInfo> fileInfos = getFileInfos(inputFolder, filter);
+  loadAllQuickIds();
+  loadAllResources();
   // Clean the quick id's aswell
-  QMap<QString, QPair<qint64, QString> > quickIdsCleaned;
+  QMap<QString, QuickId> quickIdsCleaned;
   for(const auto &info: fileInfos) {
     QString filePath = info.absoluteFilePath();
     if(quickIds.contains(filePath)) {
@@ -958,40 +1248,58 @@ bool Cache::vacuumResources(const QString inputFolder, const QString filter,
 
   int vacuumed = 0;
   {
-    int dots = 0;
-    // Always make dotMod at least 1 or it will give "floating point exception" when modulo
-    int dotMod = resources.size() * 0.1 + 1;
-
-    QMutableListIterator<Resource> it(resources);
-    while(it.hasNext()) {
-      if(dots % dotMod == 0) {
-	printf(".");
-	fflush(stdout);
+    QSet<QString> cacheIds;
+    cacheIds.reserve(cacheIdList.size());
+    for(const auto &cacheId: cacheIdList) {
+      cacheIds.insert(cacheId);
+    }
+
+    QList<Resource> vacuumList;
+    QList<QString> mediaFiles;
+    for(const auto &res: resources.toList()) {
+      if(cacheIds.contains(res.cacheId)) {
+	continue;
       }
-      dots++;
-      Resource res = it.next();
-      bool remove = true;
-      for(const auto &cacheId: cacheIdList) {
-	if(res.cacheId == cacheId) {
-	  remove = false;
-	  break;
-	}
+      vacuumList.append(res);
+      if((res.type == "cover" || res.type == "screenshot" ||
+	  res.type == "wheel" || res.type == "marquee" ||
+	  res.type == "video") && isLastMediaRef(res.value)) {
+	mediaFiles.append(res.value);
       }
-      if(remove) {
-	if(res.type == "cover" || res.type == "screenshot" ||
-	   res.type == "wheel" || res.type == "marquee" ||
-	   res.type == "video") {
-	  if(!QFile::remove(cacheDir.absolutePath() + "/" + res.value)) {
-	    printf("Couldn't purge media file '%s', skipping...\n", res.value.toStdString().c_str());
-	    continue;
-	  }
+    }
+
+    // Deleting is mostly waiting on the file system, so do all of it in one parallel batch
+    QElapsedTimer deleteTimer;
+    deleteTimer.start();
+    QString absolutePath = cacheDir.absolutePath();
+    QList<QString> failedFiles =
+      QtConcurrent::blockingFiltered(mediaFiles, [absolutePath](const QString &mediaFile) {
+	  return !QFile::remove(absolutePath + "/" + mediaFile);
+	});
+    QSet<QString> failed;
+    for(const auto &mediaFile: failedFiles) {
+      printf("Couldn't purge media file '%s', skipping...\n", mediaFile.toStdString().c_str());
+      failed.insert(mediaFile);
+    }
+
+    for(const auto &res: vacuumList) {
+      if(failed.contains(res.value)) {
+	// Kept, so restore the reference dropped by 'isLastMediaRef' above
+	if(res.value.left(6) == "blobs/") {
+	  blobRefs[res.value]++;
 	}
-	if(verbosity > 1)
-	  printf("Purged resource for '%s' with value '%s'...\n", res.cacheId.toStdString().c_str(),
-		 res.value.toStdString().c_str());
-	it.remove();
-	vacuumed++;
+	continue;
       }
+      if(verbosity > 1)
+	printf("Purged resource for '%s' with value '%s'...\n", res.cacheId.toStdString().c_str(),
+	       res.value.toStdString().c_str());
+      resources.remove(res.cacheId, res.type, res.source);
+      vacuumed++;
+    }
+    if(!mediaFiles.isEmpty()) {
+      qint64 elapsed = deleteTimer.elapsed();
+      printf(", deleted %d media files at %d files/s", mediaFiles.length() - failedFiles.length(),
+	     (int)(mediaFiles.length() * 1000 / (elapsed > 0?elapsed:1)));
     }
   }
   printf("\033[1;32m Done!\033[0m\n");
@@ -1007,6 +1315,16 @@ bool Cache::vacuumResources(const QString inputFolder, const QString filter,
 
 void Cache::showStats(int verbosity)
 {
+  loadAllResources();
+  resCountsMap.clear();
+  QHash<QString, int> blobCounts;
+  for(const auto &resource: resources.toList()) {
+    addToResCounts(resource.source, resource.type);
+    if(resource.value.left(6) == "blobs/") {
+      blobCounts[resource.value]++;
+    }
+  }
+
   printf("Resource cache stats for selected platform:\n");
   if(verbosity == 1) {
     int titles = 0;
@@ -1077,6 +1395,17 @@ void Cache::showStats(int verbosity)
       printf("  Videos       : %d\n", it.value().videos);
     }
   }
+  if(verbosity >= 1 && !blobCounts.isEmpty()) {
+    qint64 bytesSaved = 0;
+    for(QHash<QString, int>::const_iterator it = blobCounts.constBegin();
+	it != blobCounts.constEnd(); ++it) {
+      if(it.value() > 1) {
+	bytesSaved += QFileInfo(cacheDir.absolutePath() + "/" + it.key()).size() * (it.value() - 1);
+      }
+    }
+    printf("Shared media files saved %lld bytes (%lld MB) of disk space.\n",
+	   bytesSaved, bytesSaved / 1024 / 1024);
+  }
   printf("\n");
 }
 
@@ -1166,60 +1495,136 @@ void Cache::readPriorities()
 
 bool Cache::write(const bool onlyQuickId)
 {
-  QMutexLocker locker(&cacheMutex);
+  waitForEncodes();
+  stopMediaCheck();
+  QWriteLocker locker(&cacheLock);
 
-  QFile quickIdFile(cacheDir.absolutePath() + "/quickid.xml");
-  if(quickIdFile.open(QIODevice::WriteOnly)) {
-    printf("Writing quick id xml, please wait... ");
+  bool writeXml = (cacheFormat != "binary");
+  bool writeBinary = (cacheFormat == "binary" || cacheFormat == "both");
+
+  {
+    QMutexLocker quickIdLocker(&quickIdMutex);
+    loadAllQuickIds();
+    printf("Writing quick id %s, please wait... ", (writeXml?"xml":"cache"));
     fflush(stdout);
-    QXmlStreamWriter xml(&quickIdFile);
-    xml.setAutoFormatting(true);
-    xml.writeStartDocument();
-    xml.writeStartElement("quickids");
-    for(const auto &key: quickIds.keys()) {
-      xml.writeStartElement("quickid");
-      xml.writeAttribute("filepath", key);
-      xml.writeAttribute("timestamp", QString::number(quickIds[key].first));
-      xml.writeAttribute("id", quickIds[key].second);
-      xml.writeEndElement();
+    if(writeXml) {
+      QSaveFile quickIdFile(cacheDir.absolutePath() + "/quickid.xml");
+      if(quickIdFile.open(QIODevice::WriteOnly)) {
+	QXmlStreamWriter xml(&quickIdFile);
+	xml.setAutoFormatting(true);
+	xml.writeStartDocument();
+	xml.writeStartElement("quickids");
+	for(QMap<QString, QuickId>::const_iterator it = quickIds.constBegin();
+	    it != quickIds.constEnd(); ++it) {
+	  const QuickId &quickId = it.value();
+	  xml.writeStartElement("quickid");
+	  xml.writeAttribute("filepath", it.key());
+	  xml.writeAttribute("timestamp", QString::number(quickId.timestamp));
+	  xml.writeAttribute("id", quickId.cacheId);
+	  if(quickId.size != -1) {
+	    xml.writeAttribute("size", QString::number(quickId.size));
+	  }
+	  if(quickId.inode != 0) {
+	    xml.writeAttribute("inode", QString::number(quickId.inode));
+	  }
+	  if(quickId.digests & FileHasher::CRC32) {
+	    xml.writeAttribute("crc32", QString::number(quickId.crc32, 16));
+	  }
+	  if(quickId.digests & FileHasher::MD5) {
+	    xml.writeAttribute("md5", quickId.md5.toHex());
+	  }
+	  if(quickId.digests & FileHasher::SHA1) {
+	    xml.writeAttribute("sha1", quickId.sha1.toHex());
+	  }
+	  xml.writeEndElement();
+	}
+	xml.writeEndElement();
+	xml.writeEndDocument();
+	quickIdFile.commit();
+      }
+    }
+    if(writeBinary) {
+      BinaryCache::writeQuickIds(cacheDir.absolutePath() + "/quickid.bin", quickIds);
     }
-    xml.writeEndElement();
-    xml.writeEndDocument();
     printf("\033[1;32mDone!\033[0m\n");
-    quickIdFile.close();
     if(onlyQuickId) {
       return true;
     }
   }
 
-  bool result = false;
-  QFile cacheFile(cacheDir.absolutePath() + "/db.xml");
-  if(cacheFile.open(QIODevice::WriteOnly)) {
-    printf("Writing %d (%d new) resources to cache, please wait... ",
-	   resources.length(), resources.length() - resAtLoad);
-    fflush(stdout);
-    QXmlStreamWriter xml(&cacheFile);
-    xml.setAutoFormatting(true);
-    xml.writeStartDocument();
-    xml.writeStartElement("resources");
-    for(const auto &resource: resources) {
-      xml.writeStartElement("resource");
-      xml.writeAttribute("id", resource.cacheId);
-      xml.writeAttribute("type", resource.type);
-      xml.writeAttribute("source", resource.source);
-      xml.writeAttribute("timestamp", QString::number(resource.timestamp));
-      xml.writeCharacters(resource.value);
+  loadAllResources();
+  QList<Resource> allResources = resources.toList();
+  printf("Writing %d (%d new) resources to cache, please wait... ",
+	 allResources.length(), allResources.length() - resAtLoad);
+  fflush(stdout);
+  bool result = true;
+  if(writeXml) {
+    QSaveFile cacheFile(cacheDir.absolutePath() + "/db.xml");
+    if(cacheFile.open(QIODevice::WriteOnly)) {
+      QXmlStreamWriter xml(&cacheFile);
+      xml.setAutoFormatting(true);
+      xml.writeStartDocument();
+      xml.writeStartElement("resources");
+      for(const auto &resource: allResources) {
+	xml.writeStartElement("resource");
+	xml.writeAttribute("id", resource.cacheId);
+	xml.writeAttribute("type", resource.type);
+	xml.writeAttribute("source", resource.source);
+	xml.writeAttribute("timestamp", QString::number(resource.timestamp));
+	xml.writeCharacters(resource.value);
+	xml.writeEndElement();
+      }
       xml.writeEndElement();
+      xml.writeEndDocument();
+      if(!cacheFile.commit()) {
+	result = false;
+      }
+    } else {
+      result = false;
+    }
+  }
+  if(writeBinary &&
+     !BinaryCache::writeResources(cacheDir.absolutePath() + "/db.bin", allResources)) {
+    result = false;
+  }
+  if(result) {
+    removeUnusedBlobs();
+    QMutexLocker quickIdLocker(&quickIdMutex);
+    // Everything is in the main cache files now, so the journal can start over
+    if(journal.isOpen()) {
+      journal.reset();
+    } else if(QFileInfo::exists(cacheDir.absolutePath() + "/db.journal")) {
+      QFile::remove(cacheDir.absolutePath() + "/db.journal");
     }
-    xml.writeEndElement();
-    xml.writeEndDocument();
-    result = true;
     printf("\033[1;32mDone!\033[0m\n\n");
-    cacheFile.close();
+  } else {
+    printf("\033[1;31mFailed!\033[0m\n\n");
   }
   return result;
 }
 
+// Used at the end of a run. Everything added during the run is already in
+// the journal, so the main cache files are only rewritten once the journal
+// has grown past 'cacheJournalLimit'
+bool Cache::sync(const bool onlyQuickId)
+{
+  waitForEncodes();
+  stopMediaCheck();
+  if(!journal.isOpen()) {
+    return write(onlyQuickId);
+  }
+  qint64 journalSize = journal.size();
+  if(journalSize >= (qint64)journalLimit * 1024 * 1024) {
+    // Do a full write even for quick id only runs, otherwise the journal never shrinks
+    return write();
+  }
+  // Blobs released during the run are removed by the next full write, since
+  // only then are all resources loaded to tell whether they are still used
+  printf("Cache journal holds %lld KB of changes, postponing full cache write until it passes %d MB.\n\n",
+	 journalSize / 1024, journalLimit);
+  return true;
+}
+
 // This verifies all attached media files and deletes those that have no entry in the cache
 void Cache::validate()
 {
@@ -1227,16 +1632,20 @@ void Cache::validate()
 
   printf("Starting resource cache validation run, please wait...\n");
 
-  if(!QFileInfo::exists(cacheDir.absolutePath() + "/db.xml")) {
-    printf("'db.xml' not found, cache cleaning cancelled...\n");
+  if(!QFileInfo::exists(cacheDir.absolutePath() + "/db.xml") &&
+     !QFileInfo::exists(cacheDir.absolutePath() + "/db.bin")) {
+    printf("Neither 'db.xml' nor 'db.bin' found, cache cleaning cancelled...\n");
     return;
   }
 
+  loadAllResources();
+
   QDir coversDir(cacheDir.absolutePath() + "/covers", "*.*", QDir::Name, QDir::Files);
   QDir screenshotsDir(cacheDir.absolutePath() + "/screenshots", "*.*", QDir::Name, QDir::Files);
   QDir wheelsDir(cacheDir.absolutePath() + "/wheels", "*.*", QDir::Name, QDir::Files);
   QDir marqueesDir(cacheDir.absolutePath() + "/marquees", "*.*", QDir::Name, QDir::Files);
   QDir videosDir(cacheDir.absolutePath() + "/videos", "*.*", QDir::Name, QDir::Files);
+  QDir blobsDir(cacheDir.absolutePath() + "/blobs", "*.*", QDir::Name, QDir::Files);
 
   QDirIterator coversDirIt(coversDir.absolutePath(),
 			   QDir::Files | QDir::NoDotAndDotDot,
@@ -1258,6 +1667,10 @@ void Cache::validate()
 			   QDir::Files | QDir::NoDotAndDotDot,
 			   QDirIterator::Subdirectories);
 
+  QDirIterator blobsDirIt(blobsDir.absolutePath(),
+			  QDir::Files | QDir::NoDotAndDotDot,
+			  QDirIterator::Subdirectories);
+
   int filesDeleted = 0;
   int filesNoDelete = 0;
 
@@ -1266,6 +1679,7 @@ void Cache::validate()
   verifyFiles(wheelsDirIt, filesDeleted, filesNoDelete, "wheel");
   verifyFiles(marqueesDirIt, filesDeleted, filesNoDelete, "marquee");
   verifyFiles(videosDirIt, filesDeleted, filesNoDelete, "video");
+  verifyFiles(blobsDirIt, filesDeleted, filesNoDelete, "blob");
 
   if(filesDeleted == 0 && filesNoDelete == 0) {
     printf("No inconsistencies found in the database. :)\n\n");
@@ -1281,8 +1695,9 @@ void Cache::validate()
 void Cache::verifyFiles(QDirIterator &dirIt, int &filesDeleted, int &filesNoDelete, QString resType)
 {
   QList<QString> resFileNames;
-  for(const auto &resource: resources) {
-    if(resource.type == resType) {
+  for(const auto &resource: resources.toList()) {
+    // Blobs are shared between all media types
+    if(resType == "blob"?resource.value.left(6) == "blobs/":resource.type == resType) {
       QFileInfo resInfo(cacheDir.absolutePath() + "/" + resource.value);
       resFileNames.append(resInfo.absoluteFilePath());
     }
@@ -1307,49 +1722,124 @@ void Cache::verifyFiles(QDirIterator &dirIt, int &filesDeleted, int &filesNoDele
 void Cache::merge(Cache &mergeCache, bool overwrite, const QString &mergeCacheFolder)
 {
   printf("Merging databases, please wait...\n");
-  QList<Resource> mergeResources = mergeCache.getResources();
+  loadAllResources();
 
   QDir mergeCacheDir(mergeCacheFolder);
+  QString absolutePath = cacheDir.absolutePath();
+  QString mergeAbsolutePath = mergeCacheDir.absolutePath();
 
   int resUpdated = 0;
   int resMerged = 0;
+  QAtomicInt filesCloned;
+  QAtomicInt filesLinked;
 
-  for(const auto &mergeResource: mergeResources) {
-    bool resExists = false;
-    // This type of iterator ensures we can delete items while iterating
-    QMutableListIterator<Resource> it(resources);
-    while(it.hasNext()) {
-      Resource res = it.next();
-      if(res.cacheId == mergeResource.cacheId &&
-	 res.type == mergeResource.type &&
-	 res.source == mergeResource.source) {
+  struct MediaCopy {
+    Resource resource;
+    QString sourceValue;
+    bool updated;
+    bool copied;
+  };
+  // Media files are copied in batches by the thread pool, their resources are
+  // added afterwards in the same order they were read
+  QList<MediaCopy> mediaCopies;
+  QSet<QString> pendingValues;
+  // Cache id, type and source of the resources in 'mediaCopies'
+  QSet<QString> pendingKeys;
+  auto copyPending = [&]() {
+    QtConcurrent::blockingMap(mediaCopies, [&](MediaCopy &mediaCopy) {
+	QString source = mergeAbsolutePath + "/" + mediaCopy.sourceValue;
+	if(dedupMedia && mediaCopy.resource.type != "video") {
+	  QFile sourceFile(source);
+	  mediaCopy.copied = (sourceFile.open(QIODevice::ReadOnly) &&
+			      saveBlob(mediaCopy.resource, sourceFile.readAll(),
+				       absolutePath + "/" + mediaCopy.sourceValue));
+	  return;
+	}
+	QString destination = absolutePath + "/" + mediaCopy.resource.value;
+	bool blob = (mediaCopy.resource.value.left(6) == "blobs/");
+	// Shared blobs from the other cache might already be here
+	if(blob && QFileInfo::exists(destination)) {
+	  mediaCopy.copied = true;
+	  return;
+	}
+	cacheDir.mkpath(QFileInfo(destination).absolutePath());
+	int method = copyMediaFile(source, destination, blob);
+	if(method == 1) {
+	  filesCloned.fetchAndAddRelaxed(1);
+	} else if(method == 2) {
+	  filesLinked.fetchAndAddRelaxed(1);
+	}
+	mediaCopy.copied = (method != 0);
+      });
+    for(const auto &mediaCopy: mediaCopies) {
+      if(!mediaCopy.copied) {
+	printf("Couldn't copy media file '%s', skipping...\n",
+	       mediaCopy.sourceValue.toStdString().c_str());
+	continue;
+      }
+      if(mediaCopy.updated) {
+	resUpdated++;
+      } else {
+	resMerged++;
+      }
+      resources.append(mediaCopy.resource);
+      if(blobRefsCounted && mediaCopy.resource.value.left(6) == "blobs/") {
+	blobRefs[mediaCopy.resource.value]++;
+      }
+    }
+    mediaCopies.clear();
+    pendingValues.clear();
+    pendingKeys.clear();
+  };
+
+  // The resources of the other cache are streamed rather than loaded all at once
+  mergeCache.streamResources([&](const Resource &mergeResource) {
+      QString key = mergeResource.cacheId + "/" + mergeResource.type + "/" + mergeResource.source;
+      // A resource waiting to be copied must be in 'resources' before this one is compared to it
+      if(pendingKeys.contains(key)) {
+	copyPending();
+      }
+      bool resExists = false;
+      if(resources.contains(mergeResource.cacheId, mergeResource.type, mergeResource.source)) {
 	if(overwrite) {
+	  Resource res = resources.value(mergeResource.cacheId, mergeResource.type, mergeResource.source);
 	  if(res.type == "cover" || res.type == "screenshot" ||
 	     res.type == "wheel" || res.type == "marquee" ||
 	     res.type == "video") {
-	    if(!QFile::remove(cacheDir.absolutePath() + "/" + res.value)) {
+	    if(!removeMediaFile(res.value)) {
 	      printf("Couldn't remove media file '%s' for updating, skipping...\n", res.value.toStdString().c_str());
-	      continue;
+	      resExists = true;
 	    }
-	    
 	  }
-	  it.remove();
+	  if(!resExists) {
+	    resources.remove(res.cacheId, res.type, res.source);
+	  }
 	} else {
 	  resExists = true;
-	  break;
 	}
       }
-    }
-    if(!resExists) {
+      if(resExists) {
+	return;
+      }
       if(mergeResource.type == "cover" || mergeResource.type == "screenshot" ||
 	 mergeResource.type == "wheel" || mergeResource.type == "marquee" ||
 	 mergeResource.type == "video") {
-	cacheDir.mkpath(QFileInfo(cacheDir.absolutePath() + "/" + mergeResource.value).absolutePath());
-	if(!QFile::copy(mergeCacheDir.absolutePath() + "/" + mergeResource.value,
-			cacheDir.absolutePath() + "/" + mergeResource.value)) {
-	  printf("Couldn't copy media file '%s', skipping...\n",  mergeResource.value.toStdString().c_str());
-	  continue;
+	// Never copy to the same file twice in one batch
+	if(pendingValues.contains(mergeResource.value)) {
+	  copyPending();
 	}
+	MediaCopy mediaCopy;
+	mediaCopy.resource = mergeResource;
+	mediaCopy.sourceValue = mergeResource.value;
+	mediaCopy.updated = overwrite;
+	mediaCopy.copied = false;
+	mediaCopies.append(mediaCopy);
+	pendingValues.insert(mergeResource.value);
+	pendingKeys.insert(key);
+	if(mediaCopies.length() >= 256) {
+	  copyPending();
+	}
+	return;
       }
       if(overwrite) {
 	resUpdated++;
@@ -1357,15 +1847,106 @@ void Cache::merge(Cache &mergeCache, bool overwrite, const QString &mergeCacheFo
 	resMerged++;
       }
       resources.append(mergeResource);
-    }
+    });
+  copyPending();
+
+  if(filesCloned.load() > 0 || filesLinked.load() > 0) {
+    printf("Shared %d media file(s) with the other cache instead of copying them.\n",
+	   filesCloned.load() + filesLinked.load());
   }
   printf("Successfully updated %d resource(s) in cache!\n", resUpdated);
   printf("Successfully merged %d new resource(s) into cache!\n\n", resMerged);
 }
 
-QList<Resource> Cache::getResources()
+// Hands each resource of this cache folder to 'handle' in the order they
+// were written, without keeping the main cache file in memory. Only the
+// newest version of a resource is handed over, so resources replaced by
+// changes still held in the journal are skipped, just like when the cache is read
+bool Cache::streamResources(const std::function<void(const Resource &)> &handle)
+{
+  // The journal is small, so it is read first to know which resources it
+  // replaces or removes
+  ResourceStore journalStore;
+  ResourceStore journalRemovalStore;
+  {
+    QList<Resource> journalResources;
+    QList<Resource> journalRemovals;
+    QMap<QString, QuickId> journalQuickIds;
+    if(CacheJournal::read(cacheDir.absolutePath() + "/db.journal",
+			  journalResources, journalRemovals, journalQuickIds)) {
+      for(const auto &resource: journalResources) {
+	journalStore.append(resource);
+      }
+      for(const auto &removal: journalRemovals) {
+	journalRemovalStore.append(removal);
+      }
+    }
+  }
+  auto handleCurrent = [&](const Resource &resource) {
+    if(!journalStore.contains(resource.cacheId, resource.type, resource.source) &&
+       !journalRemovalStore.contains(resource.cacheId, resource.type, resource.source)) {
+      handle(resource);
+    }
+  };
+
+  bool result = false;
+  if(binaryIsNewer("db")) {
+    BinaryCache binCache;
+    if(binCache.openResources(cacheDir.absolutePath() + "/db.bin")) {
+      for(int a = 0; a < binCache.length(); ++a) {
+	handleCurrent(binCache.resourceAt(a));
+      }
+      result = true;
+    }
+  }
+  if(!result) {
+    result = parseResourceXml(handleCurrent);
+  }
+  QList<Resource> journalResources = journalStore.toList();
+  for(const auto &resource: journalResources) {
+    handle(resource);
+  }
+  return result || !journalResources.isEmpty();
+}
+
+// Returns 1 if the file was cloned with a copy-on-write reflink, 2 if it was
+// hardlinked, 3 if it was copied and 0 if it failed. Only immutable files,
+// such as blobs, may be hardlinked, since the two caches end up sharing them
+int Cache::copyMediaFile(const QString &source, const QString &destination,
+			 const bool allowHardlink)
 {
-  return resources;
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+  int sourceFd = ::open(QFile::encodeName(source).constData(), O_RDONLY);
+  if(sourceFd >= 0) {
+    int destinationFd = ::open(QFile::encodeName(destination).constData(),
+			       O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if(destinationFd >= 0) {
+      bool cloned = (ioctl(destinationFd, FICLONE, sourceFd) == 0);
+      ::close(destinationFd);
+      ::close(sourceFd);
+      if(cloned) {
+	return 1;
+      }
+      // Different file systems or no reflink support, clean up and try the next way
+      QFile::remove(destination);
+    } else {
+      ::close(sourceFd);
+    }
+  }
+#endif
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+  if(allowHardlink &&
+     ::link(QFile::encodeName(source).constData(),
+	    QFile::encodeName(destination).constData()) == 0) {
+    return 2;
+  }
+#else
+  Q_UNUSED(allowHardlink);
+#endif
+  if(QFile::copy(source, destination)) {
+    return 3;
+  }
+  return 0;
 }
     
 void Cache::addResources(GameEntry &entry, const Settings &config, QString &output)
@@ -1433,7 +2014,7 @@ void Cache::addResources(GameEntry &entry, const Settings &config, QString &outp
       resource.value = entry.releaseDate;
       addResource(resource, entry, cacheAbsolutePath, config, output);
     }
-    if(entry.videoData != "" && entry.videoFormat != "") {
+    if((entry.videoData != "" || !entry.videoTempFile.isEmpty()) && entry.videoFormat != "") {
       resource.type = "video";
       resource.value = "videos/" + entry.source + "/" + entry.cacheId + "." + entry.videoFormat;
       addResource(resource, entry, cacheAbsolutePath, config, output);
@@ -1459,6 +2040,11 @@ void Cache::addResources(GameEntry &entry, const Settings &config, QString &outp
       addResource(resource, entry, cacheAbsolutePath, config, output);
     }
   }
+  // Only left behind if the video wasn't cached
+  if(!entry.videoTempFile.isEmpty()) {
+    QFile::remove(entry.videoTempFile);
+    entry.videoTempFile = "";
+  }
 }
 
 void Cache::addResource(Resource &resource,
@@ -1467,23 +2053,21 @@ void Cache::addResource(Resource &resource,
 			const Settings &config,
 			QString &output)
 {
-  QMutexLocker locker(&cacheMutex);
-  bool notFound = true;
-  // This type of iterator ensures we can delete items while iterating
-  QMutableListIterator<Resource> it(resources);
-  while(it.hasNext()) {
-    Resource res = it.next();
-    if(res.cacheId == resource.cacheId &&
-       res.type == resource.type &&
-       res.source == resource.source) {
-      if(config.refresh) {
-	it.remove();
-      } else {
-	notFound = false;
-      }
-      break;
-    }
+  // Encoding and writing the media file below is done without holding 'cacheLock'
+  int bucket = qHash(resource.cacheId) % idMutexCount;
+  QMutex &idMutex = idMutexes[bucket];
+  lockMutex(idMutex);
+  QString pendingKey = resource.cacheId + "/" + resource.type + "/" + resource.source;
+  if(pendingEncodes[bucket].contains(pendingKey)) {
+    // Another file with the same cache id is already adding it
+    idMutex.unlock();
+    return;
   }
+  ensureLoaded(resource.cacheId);
+  lockForRead();
+  bool notFound = (config.refresh ||
+		   !resources.contains(resource.cacheId, resource.type, resource.source));
+  cacheLock.unlock();
 
   if(notFound) {
     bool okToAppend = true;
@@ -1502,58 +2086,31 @@ void Cache::addResource(Resource &resource,
       } else if(resource.type == "marquee") {
 	imageData = &entry.marqueeData;
       }
-      if(config.cacheResize) {
-	QImage image;
-	if(imageData->size() > 0 &&
-	   image.loadFromData(*imageData) &&
-	   !image.isNull()) {
-	  int max = 800;
-	  if(image.width() > max || image.height() > max) {
-	    image = image.scaled(max, max, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-	  }
-	  QByteArray resizedData;
-	  QBuffer b(&resizedData);
-	  b.open(QIODevice::WriteOnly);
-	  if((image.hasAlphaChannel() && hasAlpha(image)) || resource.type == "screenshot") {
-	    okToAppend = image.save(&b, "png");
-	  } else {
-	    okToAppend = image.save(&b, "jpg", config.jpgQuality);
-	  }
-	  b.close();
-	  if(imageData->size() > resizedData.size()) {
-	    if(config.verbosity >= 3) {
-	      printf("%s: '%d' > '%d', choosing resize for optimal result!\n",
-		     resource.type.toStdString().c_str(),
-		     imageData->size(),
-		     resizedData.size());
-	    }
-	    *imageData = resizedData;
-	  }
-	} else {
-	  okToAppend = false;
-	}
-      }
-      if(okToAppend) {
-	QFile f(cacheFile);
-	if(f.open(QIODevice::WriteOnly)) {
-	  f.write(*imageData);
-	  f.close();
-	} else {
-	  output.append("Error writing file: '" + f.fileName() + "' to cache. Please check permissions.");
-	  okToAppend = false;
-	}
-      } else {
-	// Image was faulty and could not be saved to cache so we clear
-	// the QByteArray data in game entry to make sure we get a "NO"
-	// in the terminal output from scraperworker.cpp.
-	imageData->clear();
-      }
+      // Blocks if the encode pool is full, so downloads can't pile up in memory
+      encodeSlots.acquire();
+      pendingEncodes[bucket].insert(pendingKey);
+      encodePool.start(new EncodeJob(this, resource, *imageData, cacheFile, config));
+      idMutex.unlock();
+      return;
     } else if(resource.type == "video") {
-      if(entry.videoData.size() <= config.videoSizeLimit) {
+      qint64 videoSize = entry.videoData.size();
+      if(!entry.videoTempFile.isEmpty()) {
+	videoSize = QFileInfo(entry.videoTempFile).size();
+      }
+      if(videoSize <= config.videoSizeLimit) {
 	QFile f(cacheFile);
-	if(f.open(QIODevice::WriteOnly)) {
+	bool written = false;
+	if(!entry.videoTempFile.isEmpty()) {
+	  // Streamed to a temporary file in the cache folder, so it only needs renaming
+	  QFile::remove(cacheFile);
+	  written = (QFile::rename(entry.videoTempFile, cacheFile) ||
+		     QFile::copy(entry.videoTempFile, cacheFile));
+	} else if(f.open(QIODevice::WriteOnly)) {
 	  f.write(entry.videoData);
 	  f.close();
+	  written = true;
+	}
+	if(written) {
 	  if(!config.videoConvertCommand.isEmpty()) {
 	    output.append("Video conversion: ");
 	    if(doVideoConvert(resource,
@@ -1577,23 +2134,215 @@ void Cache::addResource(Resource &resource,
 	okToAppend = false;
       }
     }
+    commitResource(resource, okToAppend, config.refresh);
+  }
+  idMutex.unlock();
+}
 
-    if(okToAppend) {
-      if(resource.type == "cover" ||
-	 resource.type == "screenshot" ||
-	 resource.type == "wheel" ||
-	 resource.type == "marquee") {
-	// Remove old style cache image if it exists
-	if(QFile::exists(cacheFile + ".png")) {
-	  QFile::remove(cacheFile + ".png");
+// Runs in 'encodePool'. Resizes and re-encodes the image if 'cacheResize' is
+// set and writes it to the cache folder
+bool Cache::encodeImage(Resource &resource, QByteArray &imageData,
+			const QString &cacheFile, const bool cacheResize,
+			const int jpgQuality, const int verbosity)
+{
+  bool okToAppend = true;
+  int max = 800;
+  bool fastPath = false;
+  if(cacheResize && imageData.size() > 0) {
+    // Only the header is read here. A jpeg that doesn't need resizing has no
+    // alpha and is already compressed, so decoding and re-encoding it is wasted.
+    // A truncated download is missing the end of image marker, and gets the
+    // full decode below which rejects it
+    QBuffer headerBuffer(&imageData);
+    headerBuffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&headerBuffer);
+    QSize size = reader.size();
+    if(reader.canRead() && reader.format() == "jpeg" && size.isValid() &&
+       size.width() <= max && size.height() <= max &&
+       imageData.endsWith(QByteArray("\xFF\xD9", 2))) {
+      fastPath = true;
+      fastPathImages.fetchAndAddRelaxed(1);
+    }
+  }
+  if(cacheResize && !fastPath) {
+    QImage image;
+    if(imageData.size() > 0 &&
+       image.loadFromData(imageData) &&
+       !image.isNull()) {
+      if(image.width() > max || image.height() > max) {
+	image = image.scaled(max, max, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+      }
+      QByteArray resizedData;
+      QBuffer b(&resizedData);
+      b.open(QIODevice::WriteOnly);
+      if((image.hasAlphaChannel() && hasAlpha(image)) || resource.type == "screenshot") {
+	okToAppend = image.save(&b, "png");
+      } else {
+	okToAppend = image.save(&b, "jpg", jpgQuality);
+      }
+      b.close();
+      if(imageData.size() > resizedData.size()) {
+	if(verbosity >= 3) {
+	  printf("%s: '%d' > '%d', choosing resize for optimal result!\n",
+		 resource.type.toStdString().c_str(),
+		 imageData.size(),
+		 resizedData.size());
 	}
+	imageData = resizedData;
       }
-      resources.append(resource);
     } else {
-      printf("\033[1;33mWarning! Couldn't add resource to cache. Have you run out of disk space?\n\033[0m");
+      okToAppend = false;
     }
-    
   }
+  if(okToAppend && dedupMedia) {
+    return saveBlob(resource, imageData, cacheFile);
+  }
+  if(okToAppend) {
+    QFile f(cacheFile);
+    if(f.open(QIODevice::WriteOnly)) {
+      f.write(imageData);
+      f.close();
+      // Remove old style cache image if it exists
+      if(QFile::exists(cacheFile + ".png")) {
+	QFile::remove(cacheFile + ".png");
+      }
+    } else {
+      printf("Error writing file: '%s' to cache. Please check permissions.\n",
+	     f.fileName().toStdString().c_str());
+      okToAppend = false;
+    }
+  }
+  return okToAppend;
+}
+
+// Saves the media data as 'blobs/<first 2 chars of sha1>/<sha1>' and points
+// the resource at it. Identical media shared by several resources is only
+// saved once. Any file at the old per cache id location is removed
+bool Cache::saveBlob(Resource &resource, const QByteArray &data, const QString &cacheFile)
+{
+  QString hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+  resource.value = "blobs/" + hash.left(2) + "/" + hash;
+  QString blobFile = cacheDir.absolutePath() + "/" + resource.value;
+  if(!QFileInfo::exists(blobFile)) {
+    cacheDir.mkpath(QFileInfo(blobFile).absolutePath());
+    // Another thread might be saving the same blob, so never leave a partial file behind
+    QSaveFile f(blobFile);
+    if(!f.open(QIODevice::WriteOnly)) {
+      printf("Error writing file: '%s' to cache. Please check permissions.\n",
+	     blobFile.toStdString().c_str());
+      return false;
+    }
+    f.write(data);
+    if(!f.commit()) {
+      printf("Error writing file: '%s' to cache. Please check permissions.\n",
+	     blobFile.toStdString().c_str());
+      return false;
+    }
+  }
+  if(QFile::exists(cacheFile)) {
+    QFile::remove(cacheFile);
+  }
+  if(QFile::exists(cacheFile + ".png")) {
+    QFile::remove(cacheFile + ".png");
+  }
+  return true;
+}
+
+// Blobs can be shared between resources, so they are only removed once the
+// last resource pointing at them goes. Only use this after 'loadAllResources'
+bool Cache::removeMediaFile(const QString &value)
+{
+  if(!isLastMediaRef(value)) {
+    return true;
+  }
+  if(QFile::remove(cacheDir.absolutePath() + "/" + value)) {
+    return true;
+  }
+  // The resource is kept when the file can't be removed, and so is its reference
+  if(value.left(6) == "blobs/") {
+    blobRefs[value]++;
+  }
+  return false;
+}
+
+// Drops a reference to the media file and returns true if it should be deleted
+bool Cache::isLastMediaRef(const QString &value)
+{
+  if(value.left(6) != "blobs/") {
+    return true;
+  }
+  countBlobRefs();
+  int refs = blobRefs.value(value) - 1;
+  if(refs > 0) {
+    blobRefs[value] = refs;
+    return false;
+  }
+  blobRefs.remove(value);
+  return true;
+}
+
+// Removes the blobs that no resource uses anymore, including those released
+// during earlier runs that only wrote to the journal. Only use this after
+// 'loadAllResources' while holding 'cacheLock' for writing
+void Cache::removeUnusedBlobs()
+{
+  QDirIterator blobsDirIt(cacheDir.absolutePath() + "/blobs",
+			  QDir::Files | QDir::NoDotAndDotDot,
+			  QDirIterator::Subdirectories);
+  if(!blobsDirIt.hasNext()) {
+    return;
+  }
+  countBlobRefs();
+  while(blobsDirIt.hasNext()) {
+    QString blobFile = blobsDirIt.next();
+    if(!blobRefs.contains(cacheDir.relativeFilePath(blobFile))) {
+      QFile::remove(blobFile);
+    }
+  }
+}
+
+void Cache::countBlobRefs()
+{
+  if(blobRefsCounted) {
+    return;
+  }
+  blobRefs.clear();
+  for(const auto &resource: resources.toList()) {
+    if(resource.value.left(6) == "blobs/") {
+      blobRefs[resource.value]++;
+    }
+  }
+  blobRefsCounted = true;
+}
+
+void Cache::commitResource(const Resource &resource, const bool okToAppend, const bool refresh)
+{
+  if(okToAppend) {
+    // Replaces the existing resource when refreshing
+    lockForWrite();
+    resources.append(resource);
+    blobRefsCounted = false;
+    cacheLock.unlock();
+    journal.addResource(resource);
+  } else {
+    if(refresh) {
+      lockForWrite();
+      if(resources.remove(resource.cacheId, resource.type, resource.source)) {
+	// Journaled under the lock so it can't end up behind a newer version of the resource
+	journal.addRemoval(resource);
+      }
+      blobRefsCounted = false;
+      cacheLock.unlock();
+    }
+    printf("\033[1;33mWarning! Couldn't add %s resource with cache id '%s' to cache. Have you run out of disk space?\n\033[0m",
+	   resource.type.toStdString().c_str(), resource.cacheId.toStdString().c_str());
+  }
+}
+
+// Blocks until all queued images have been encoded and added to the cache
+void Cache::waitForEncodes()
+{
+  encodePool.waitForDone();
 }
 
 bool Cache::doVideoConvert(Resource &resource,
@@ -1675,65 +2424,153 @@ bool Cache::doVideoConvert(Resource &resource,
 
 bool Cache::hasAlpha(const QImage &image)
 {
-  QRgb* constBits = (QRgb *)image.constBits();
-  for(int a = 0; a < image.width() * image.height(); ++a) {
-    if(qAlpha(constBits[a]) < 127) {
+  if(image.format() != QImage::Format_ARGB32 &&
+     image.format() != QImage::Format_ARGB32_Premultiplied) {
+    return hasAlpha(image.convertToFormat(QImage::Format_ARGB32));
+  }
+  const quint32 *pixels = (const quint32 *)image.constBits();
+  int total = image.width() * image.height();
+  int a = 0;
+  // Blocks where every alpha has its high bit set are opaque enough to skip
+  // without looking at each pixel. The AND loop is easy for the compiler to
+  // vectorize, and only blocks that fail it get the per pixel check
+  for(; a + 16 <= total; a += 16) {
+    quint32 alphaBits = 0xff000000;
+    for(int b = 0; b < 16; ++b) {
+      alphaBits &= pixels[a + b];
+    }
+    if(alphaBits & 0x80000000) {
+      continue;
+    }
+    for(int b = 0; b < 16; ++b) {
+      if(qAlpha(pixels[a + b]) < 127) {
+	return true;
+      }
+    }
+  }
+  for(; a < total; ++a) {
+    if(qAlpha(pixels[a]) < 127) {
       return true;
     }
   }
   return false;
 }
 
+int Cache::getFastPathImages()
+{
+  return fastPathImages.load();
+}
+
 void Cache::addQuickId(const QFileInfo &info, const QString &cacheId) {
-  QMutexLocker locker(&quickIdMutex);
-  QPair<qint64, QString> pair; // Quick id pair
-  pair.first = info.lastModified().toMSecsSinceEpoch();
-  pair.second = cacheId;
-  quickIds[info.absoluteFilePath()] = pair;
+  QuickId quickId;
+  // Keep any digests that were stored for this exact file while calculating the id
+  if(!findQuickId(info.absoluteFilePath(), quickId) || !quickIdMatches(quickId, info)) {
+    quickId = QuickId();
+  }
+  quickId.timestamp = info.lastModified().toMSecsSinceEpoch();
+  quickId.cacheId = cacheId;
+  quickId.size = info.size();
+  quickId.inode = FileHasher::getInode(info);
+  storeQuickId(info.absoluteFilePath(), quickId);
 }
 
 QString Cache::getQuickId(const QFileInfo &info) {
-  QMutexLocker locker(&quickIdMutex);
-  if(quickIds.contains(info.absoluteFilePath()) &&
-     info.lastModified().toMSecsSinceEpoch() <= quickIds[info.absoluteFilePath()].first) {
-    return quickIds[info.absoluteFilePath()].second;
+  QuickId quickId;
+  if(findQuickId(info.absoluteFilePath(), quickId) && quickIdMatches(quickId, info)) {
+    return quickId.cacheId;
   }
   return QString();
 }
 
-bool Cache::hasEntries(const QString &cacheId, const QString scraper)
+bool Cache::getHashes(const QFileInfo &info, FileHashes &hashes)
 {
-  QMutexLocker locker(&cacheMutex);
-  for(const auto &res: resources) {
-    if(scraper.isEmpty()) {
-      if(res.cacheId == cacheId) {
-	return true;
-      }
-    } else {
-      if(res.cacheId == cacheId && res.source == scraper) {
-	return true;
-      }
-    }
+  QuickId quickId;
+  if(!findQuickId(info.absoluteFilePath(), quickId) || !quickIdMatches(quickId, info) ||
+     quickId.digests == 0) {
+    return false;
   }
-  return false;
+  hashes.size = info.size();
+  hashes.modified = info.lastModified().toMSecsSinceEpoch();
+  hashes.digests = quickId.digests;
+  hashes.md5 = quickId.md5;
+  hashes.sha1 = quickId.sha1;
+  hashes.crc32 = quickId.crc32;
+  return true;
+}
+
+void Cache::addHashes(const QFileInfo &info, const FileHashes &hashes)
+{
+  QuickId quickId;
+  if(!findQuickId(info.absoluteFilePath(), quickId) || !quickIdMatches(quickId, info)) {
+    // The cache id is added separately once it is known
+    quickId = QuickId();
+  }
+  quickId.timestamp = hashes.modified;
+  quickId.size = hashes.size;
+  quickId.inode = FileHasher::getInode(info);
+  quickId.digests |= hashes.digests;
+  if(hashes.digests & FileHasher::MD5) {
+    quickId.md5 = hashes.md5;
+  }
+  if(hashes.digests & FileHasher::SHA1) {
+    quickId.sha1 = hashes.sha1;
+  }
+  if(hashes.digests & FileHasher::CRC32) {
+    quickId.crc32 = hashes.crc32;
+  }
+  storeQuickId(info.absoluteFilePath(), quickId);
+}
+
+bool Cache::findQuickId(const QString &filePath, QuickId &quickId)
+{
+  lockMutex(quickIdMutex);
+  bool found = quickIds.contains(filePath);
+  if(found) {
+    quickId = quickIds.value(filePath);
+  }
+  quickIdMutex.unlock();
+  return found || binQuickIds.quickId(filePath, quickId);
+}
+
+// Size and inode are only compared when they are known, since quick ids
+// written by older versions don't have them
+bool Cache::quickIdMatches(const QuickId &quickId, const QFileInfo &info)
+{
+  if(info.lastModified().toMSecsSinceEpoch() > quickId.timestamp) {
+    return false;
+  }
+  if(quickId.size != -1 && quickId.size != info.size()) {
+    return false;
+  }
+  quint64 inode = FileHasher::getInode(info);
+  if(quickId.inode != 0 && inode != 0 && quickId.inode != inode) {
+    return false;
+  }
+  return true;
+}
+
+void Cache::storeQuickId(const QString &filePath, const QuickId &quickId)
+{
+  lockMutex(quickIdMutex);
+  quickIds[filePath] = quickId;
+  quickIdMutex.unlock();
+  journal.addQuickId(filePath, quickId);
+}
+
+bool Cache::hasEntries(const QString &cacheId, const QString scraper)
+{
+  ensureLoaded(cacheId);
+  QReadLocker locker(&cacheLock);
+  return resources.contains(cacheId, scraper);
 }
 
 void Cache::fillBlanks(GameEntry &entry, const QString scraper)
 {
-  QMutexLocker locker(&cacheMutex);
-  QList<Resource> matchingResources;
+  ensureLoaded(entry.cacheId);
   // Find all resources related to this particular rom
-  for(const auto &resource: resources) {
-    if(scraper.isEmpty()) {
-      if(entry.cacheId == resource.cacheId) {
-	matchingResources.append(resource);
-      }
-    } else {
-      if(entry.cacheId == resource.cacheId && resource.source == scraper) {
-	matchingResources.append(resource);
-      }
-    }
-  }
+  lockForRead();
+  QList<Resource> matchingResources = resources.values(entry.cacheId, scraper);
+  cacheLock.unlock();
 
   {
     QString type = "title";
@@ -1882,11 +2719,10 @@ void Cache::fillBlanks(GameEntry &entry, const QString scraper)
     QString result = "";
     QString source = "";
     if(fillType(type, matchingResources, result, source)) {
+      // Videos can be large, so they are copied from 'videoFile' when needed instead of being read here
       QFileInfo info(cacheDir.absolutePath() + "/" + result);
-      QFile f(info.absoluteFilePath());
-      if(f.open(QIODevice::ReadOnly)) {
-	entry.videoData = f.readAll();
-	f.close();
+      if(info.isFile()) {
+	entry.videoSize = info.size();
 	entry.videoFormat = info.suffix();
 	entry.videoFile = info.absoluteFilePath();
 	entry.videoSrc = source;
@@ -1904,27 +2740,128 @@ bool Cache::fillType(QString &type, QList<Resource> &matchingResources,
       typeResources.append(resource);
     }
   }
-  if(typeResources.isEmpty()) {
+  int picked = pickResource(type, typeResources);
+  // A resource whose media file is gone is dropped, and the next best one is picked instead
+  while(picked != -1 && !mediaExists(typeResources.at(picked))) {
+    typeResources.removeAt(picked);
+    picked = pickResource(type, typeResources);
+  }
+  if(picked == -1) {
     return false;
   }
+  result = typeResources.at(picked).value;
+  source = typeResources.at(picked).source;
+  return true;
+}
+
+int Cache::pickResource(const QString &type, const QList<Resource> &typeResources)
+{
+  if(typeResources.isEmpty()) {
+    return -1;
+  }
   if(prioMap.contains(type)) {
     for(int a = 0; a < prioMap.value(type).length(); ++a) {
-      for(const auto &resource: typeResources) {
-	if(resource.source == prioMap.value(type).at(a)) {
-	  result = resource.value;
-	  source = resource.source;
-	  return true;
+      for(int b = 0; b < typeResources.length(); ++b) {
+	if(typeResources.at(b).source == prioMap.value(type).at(a)) {
+	  return b;
 	}
       }
     }
   }
   qint64 newest = 0;
-  for(const auto &resource: typeResources) {
-    if(resource.timestamp >= newest) {
-      newest = resource.timestamp;
-      result = resource.value;
-      source = resource.source;
+  int picked = 0;
+  for(int a = 0; a < typeResources.length(); ++a) {
+    if(typeResources.at(a).timestamp >= newest) {
+      newest = typeResources.at(a).timestamp;
+      picked = a;
     }
-  }  
-  return true;
+  }
+  return picked;
+}
+
+// Only does anything if media files weren't checked when the cache was read.
+// Removes the resource from the cache if its media file is missing
+bool Cache::mediaExists(const Resource &resource)
+{
+  if(!lazyMediaCheck ||
+     (resource.type != "cover" && resource.type != "screenshot" &&
+      resource.type != "wheel" && resource.type != "marquee" &&
+      resource.type != "video")) {
+    return true;
+  }
+  if(QFileInfo::exists(cacheDir.absolutePath() + "/" + resource.value)) {
+    return true;
+  }
+  lockForWrite();
+  // Make sure it hasn't been replaced by a freshly scraped resource in the meantime
+  if(resources.value(resource.cacheId, resource.type, resource.source).value == resource.value &&
+     resources.remove(resource.cacheId, resource.type, resource.source)) {
+    journal.addRemoval(resource);
+    mediaMissing.fetchAndAddRelaxed(1);
+  }
+  cacheLock.unlock();
+  return false;
+}
+
+void Cache::startMediaCheck()
+{
+  if(!lazyMediaCheck || mediaCheck != "background" || mediaCheckThread != nullptr) {
+    return;
+  }
+  mediaCheckAbort.storeRelease(0);
+  mediaCheckThread = new MediaCheckThread(this);
+  mediaCheckThread->start(QThread::LowestPriority);
+}
+
+void Cache::stopMediaCheck()
+{
+  if(mediaCheckThread == nullptr) {
+    return;
+  }
+  mediaCheckAbort.storeRelease(1);
+  mediaCheckThread->wait();
+  delete mediaCheckThread;
+  mediaCheckThread = nullptr;
+  if(mediaMissing.load() > 0) {
+    printf("Removed %d resources with missing media files from the cache.\n\n",
+	   mediaMissing.load());
+  }
+}
+
+// Runs in 'mediaCheckThread'. The file checks are done without holding
+// 'cacheLock' so the scraping threads are only blocked while a missing
+// resource is removed. 'binResources' is mapped read-only and is only closed
+// by 'write()' which stops this thread first, so it can be read unlocked
+void Cache::checkAllMedia()
+{
+  QList<Resource> media;
+  for(int a = 0; a < binResources.length(); ++a) {
+    media.append(binResources.resourceAt(a));
+  }
+  {
+    QReadLocker locker(&cacheLock);
+    media.append(resources.toList());
+  }
+  for(const auto &resource: media) {
+    if(mediaCheckAbort.loadAcquire()) {
+      return;
+    }
+    if(resource.type != "cover" && resource.type != "screenshot" &&
+       resource.type != "wheel" && resource.type != "marquee" &&
+       resource.type != "video") {
+      continue;
+    }
+    if(QFileInfo::exists(cacheDir.absolutePath() + "/" + resource.value)) {
+      continue;
+    }
+    QWriteLocker locker(&cacheLock);
+    loadResources(resource.cacheId);
+    // Make sure it hasn't been replaced by a freshly scraped resource in the meantime
+    if(resources.value(resource.cacheId, resource.type, resource.source).value == resource.value &&
+       !QFileInfo::exists(cacheDir.absolutePath() + "/" + resource.value)) {
+      resources.remove(resource.cacheId, resource.type, resource.source);
+      journal.addRemoval(resource);
+      mediaMissing.fetchAndAddRelaxed(1);
+    }
+  }
 }
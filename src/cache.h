@@ -26,25 +26,29 @@
 #ifndef CACHE_H
 #define CACHE_H
 
+#include <functional>
+
 #include <QObject>
 #include <QString>
 #include <QMutex>
+#include <QReadWriteLock>
 #include <QDirIterator>
 #include <QMap>
+#include <QSet>
 #include <QSharedPointer>
+#include <QThread>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
 
 #include "gameentry.h"
 #include "queue.h"
+#include "filehasher.h"
 #include "settings.h"
-
-struct Resource {
-  QString cacheId = "";
-  int version = 1;
-  QString type = "";
-  QString source = "";
-  QString value = "";
-  qint64 timestamp = 0;
-};
+#include "resourcestore.h"
+#include "binarycache.h"
+#include "cachejournal.h"
 
 struct ResCounts {
   int titles;
@@ -64,10 +68,52 @@ struct ResCounts {
   int videos;
 };
 
+class Cache;
+
+// Checks the media files of the entire cache while a scraping run is going on
+class MediaCheckThread : public QThread
+{
+public:
+  MediaCheckThread(Cache *cache);
+
+protected:
+  void run() override;
+
+private:
+  Cache *cache;
+};
+
+// Resizes, encodes and saves a downloaded image to the cache, then adds its
+// resource. Runs in the cache's encode pool so the scraping threads can move
+// on to their next game right away
+class EncodeJob : public QRunnable
+{
+public:
+  EncodeJob(Cache *cache, const Resource &resource, const QByteArray &imageData,
+	    const QString &cacheFile, const Settings &config);
+  void run() override;
+
+private:
+  Cache *cache;
+  Resource resource;
+  QString pendingKey;
+  QByteArray imageData;
+  QString cacheFile;
+  bool cacheResize;
+  int jpgQuality;
+  int verbosity;
+  bool refresh;
+};
+
 class Cache
 {
+  friend class MediaCheckThread;
+  friend class EncodeJob;
+
 public:
   Cache(const QString &cacheFolder);
+  ~Cache();
+  void setConfig(const Settings &config);
   bool createFolders(const QString &scraper);
   bool read();
   void printPriorities(QString cacheId);
@@ -82,37 +128,105 @@ public:
   void showStats(int verbosity);
   void readPriorities();
   bool write(const bool onlyQuickId = false);
+  bool sync(const bool onlyQuickId = false);
+  void startMediaCheck();
+  void stopMediaCheck();
+  int getLockWaits();
+  void waitForEncodes();
+  int getFastPathImages();
   void validate();
   void addResources(GameEntry &entry, const Settings &config, QString &output);
   void fillBlanks(GameEntry &entry, const QString scraper = "");
   bool hasEntries(const QString &cacheId, const QString scraper = "");
   void addQuickId(const QFileInfo &info, const QString &cacheId);
   QString getQuickId(const QFileInfo &info);
+  bool getHashes(const QFileInfo &info, FileHashes &hashes);
+  void addHashes(const QFileInfo &info, const FileHashes &hashes);
   void merge(Cache &mergeCache, bool overwrite, const QString &mergeCacheFolder);
-  QList<Resource> getResources();
 
  private:
   QDir cacheDir;
-  QMutex cacheMutex;
+  // Guards 'resources' and the binary cache state. Only held for lookups and
+  // updates, never while encoding or writing media files
+  QReadWriteLock cacheLock;
   QMutex quickIdMutex;
+  // Picked by cache id hash, so resources for the same cache id are added one at a time
+  static const int idMutexCount = 64;
+  QMutex idMutexes[idMutexCount];
+  // Resources queued for encoding but not committed yet, guarded by the
+  // matching id mutex. Counts as present, so a duplicate isn't encoded twice
+  QSet<QString> pendingEncodes[idMutexCount];
+  QAtomicInt lockWaits;
+
+  QThreadPool encodePool;
+  QSemaphore encodeSlots;
+  QAtomicInt fastPathImages;
+
+  QString cacheFormat = "xml";
+  int journalLimit = 0;
+  QString mediaCheck = "startup";
+  bool lazyMediaCheck = false;
+  MediaCheckThread *mediaCheckThread = nullptr;
+  QAtomicInt mediaCheckAbort;
+  QAtomicInt mediaMissing;
+  bool dedupMedia = false;
+  QHash<QString, int> blobRefs;
+  bool blobRefsCounted = false;
 
   QMap<QString, QList<QString> > prioMap;
 
   QMap<QString, ResCounts> resCountsMap;
 
-  QList<Resource> resources;
-  QMap<QString, QPair<qint64, QString> > quickIds; // filePath, timestamp + cacheId for quick lookup
+  ResourceStore resources;
+  QMap<QString, QuickId> quickIds; // filePath, cacheId and digests for quick lookup
+
+  // Memory mapped 'db.bin' and 'quickid.bin', decoded into the above on demand
+  BinaryCache binResources;
+  BinaryCache binQuickIds;
+  QSet<QString> binLoadedIds;
+
+  CacheJournal journal;
 
   QList<QFileInfo> getFileInfos(const QString &inputFolder, const QString &filter, const bool subdirs = true);
   QList<QString> getCacheIdList(const QList<QFileInfo> &fileInfos);
 
+  bool binaryIsNewer(const QString &baseName);
+  bool readQuickIdXml();
+  bool findQuickId(const QString &filePath, QuickId &quickId);
+  bool quickIdMatches(const QuickId &quickId, const QFileInfo &info);
+  void storeQuickId(const QString &filePath, const QuickId &quickId);
+  bool readResourceXml();
+  bool parseResourceXml(const std::function<void(const Resource &)> &handle);
+  bool streamResources(const std::function<void(const Resource &)> &handle);
+  bool readJournal();
+  void loadResources(const QString &cacheId);
+  void ensureLoaded(const QString &cacheId);
+  void lockForRead();
+  void lockForWrite();
+  void lockMutex(QMutex &mutex);
+  void loadAllResources();
+  void loadAllQuickIds();
   void addToResCounts(const QString source, const QString type);
   void addResource(Resource &resource, GameEntry &entry, const QString &cacheAbsolutePath,
 		   const Settings &config, QString &output);
+  bool encodeImage(Resource &resource, QByteArray &imageData,
+		   const QString &cacheFile, const bool cacheResize,
+		   const int jpgQuality, const int verbosity);
+  void commitResource(const Resource &resource, const bool okToAppend, const bool refresh);
+  bool saveBlob(Resource &resource, const QByteArray &data, const QString &cacheFile);
+  bool removeMediaFile(const QString &value);
+  bool isLastMediaRef(const QString &value);
+  void removeUnusedBlobs();
+  void countBlobRefs();
+  static int copyMediaFile(const QString &source, const QString &destination,
+			   const bool allowHardlink);
   void verifyFiles(QDirIterator &dirIt, int &filesDeleted, int &noDelete, QString resType);
   void verifyResources(int &resourcesDeleted);
   bool fillType(QString &type, QList<Resource> &matchingResources,
 		QString &result, QString &source);
+  int pickResource(const QString &type, const QList<Resource> &typeResources);
+  bool mediaExists(const Resource &resource);
+  void checkAllMedia();
   bool doVideoConvert(Resource &resource,
 		      QString &cacheFile,
 		      const QString &cacheAbsolutePath,
@@ -0,0 +1,236 @@
+/***************************************************************************
+ *            cachejournal.cpp
+ *
+ *  Sat Oct 17 22:53:16 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <iostream>
+
+#include <QDataStream>
+
+#include "cachejournal.h"
+
+#define JOURNALMAGIC "SKYJ"
+#define JOURNALVERSION 1
+#define RECORDRESOURCE 'R'
+#define RECORDQUICKID 'Q' // Only read, written by versions that didn't store sizes and digests
+#define RECORDROMINFO 'H'
+#define RECORDREMOVAL 'D'
+
+CacheJournal::CacheJournal()
+{
+}
+
+CacheJournal::~CacheJournal()
+{
+  close();
+}
+
+// Opens the journal for appending and hands back the changes it already
+// holds, in the order they were made. Anything after the last intact record
+// is cut off so new records don't end up behind garbage
+bool CacheJournal::open(const QString &fileName, QList<Resource> &resources,
+			QList<Resource> &removals, QMap<QString, QuickId> &quickIds)
+{
+  QMutexLocker locker(&journalMutex);
+  if(file.isOpen()) {
+    file.close();
+  }
+  file.setFileName(fileName);
+  if(!file.open(QIODevice::ReadWrite)) {
+    return false;
+  }
+
+  qint64 validSize = parse(file, resources, removals, quickIds);
+  if(validSize == 0) {
+    file.resize(0);
+    file.seek(0);
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out.writeRawData(JOURNALMAGIC, 4);
+    out << (quint32)JOURNALVERSION;
+  } else if(validSize < file.size()) {
+    printf("\033[1;33mCache journal is damaged past record %d, ignoring the rest...\033[0m\n",
+	   resources.length() + removals.length() + quickIds.size());
+    file.resize(validSize);
+  }
+  file.seek(file.size());
+  file.flush();
+  return true;
+}
+
+// Reads the changes of a journal without opening it for appending
+bool CacheJournal::read(const QString &fileName, QList<Resource> &resources,
+			QList<Resource> &removals, QMap<QString, QuickId> &quickIds)
+{
+  QFile journalFile(fileName);
+  if(!journalFile.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  parse(journalFile, resources, removals, quickIds);
+  return true;
+}
+
+// Returns the size of the intact part of the journal, or 0 if the header is
+// invalid. A removal drops the journaled versions of the resource that came
+// before it, so 'removals' only has to be applied to the main cache files, and
+// that has to be done before 'resources' are added
+qint64 CacheJournal::parse(QFile &journalFile, QList<Resource> &resources,
+			   QList<Resource> &removals, QMap<QString, QuickId> &quickIds)
+{
+  QDataStream in(&journalFile);
+  in.setVersion(QDataStream::Qt_5_0);
+  QByteArray magic(4, '\0');
+  quint32 version = 0;
+  if(in.readRawData(magic.data(), 4) == 4 && magic == JOURNALMAGIC) {
+    in >> version;
+  }
+  if(in.status() != QDataStream::Ok || version != JOURNALVERSION) {
+    return 0;
+  }
+  qint64 validSize = journalFile.pos();
+  while(!in.atEnd()) {
+    QByteArray record;
+    quint16 checksum = 0;
+    in >> record >> checksum;
+    if(in.status() != QDataStream::Ok ||
+       checksum != qChecksum(record.constData(), record.size())) {
+      break;
+    }
+    QDataStream recordIn(record);
+    recordIn.setVersion(QDataStream::Qt_5_0);
+    quint8 recordType = 0;
+    recordIn >> recordType;
+    if(recordType == RECORDRESOURCE) {
+      Resource resource;
+      recordIn >> resource.cacheId >> resource.type >> resource.source
+	       >> resource.value >> resource.timestamp;
+      resources.append(resource);
+    } else if(recordType == RECORDREMOVAL) {
+      Resource removal;
+      recordIn >> removal.cacheId >> removal.type >> removal.source;
+      for(int a = resources.length() - 1; a >= 0; --a) {
+	if(resources.at(a).cacheId == removal.cacheId &&
+	   resources.at(a).type == removal.type &&
+	   resources.at(a).source == removal.source) {
+	  resources.removeAt(a);
+	}
+      }
+      removals.append(removal);
+    } else if(recordType == RECORDQUICKID) {
+      QString filePath;
+      QuickId quickId;
+      recordIn >> filePath >> quickId.timestamp >> quickId.cacheId;
+      quickIds[filePath] = quickId;
+    } else if(recordType == RECORDROMINFO) {
+      QString filePath;
+      QuickId quickId;
+      recordIn >> filePath >> quickId.timestamp >> quickId.cacheId >> quickId.size
+	       >> quickId.inode >> quickId.digests >> quickId.md5 >> quickId.sha1
+	       >> quickId.crc32;
+      quickIds[filePath] = quickId;
+    }
+    validSize = journalFile.pos();
+  }
+  return validSize;
+}
+
+void CacheJournal::close()
+{
+  QMutexLocker locker(&journalMutex);
+  if(file.isOpen()) {
+    file.close();
+  }
+}
+
+bool CacheJournal::isOpen()
+{
+  QMutexLocker locker(&journalMutex);
+  return file.isOpen();
+}
+
+qint64 CacheJournal::size()
+{
+  QMutexLocker locker(&journalMutex);
+  return file.isOpen()?file.size():0;
+}
+
+// Drops all records. Only call this once the main cache files hold everything
+bool CacheJournal::reset()
+{
+  QMutexLocker locker(&journalMutex);
+  if(!file.isOpen()) {
+    return false;
+  }
+  if(!file.resize(0)) {
+    return false;
+  }
+  file.seek(0);
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_0);
+  out.writeRawData(JOURNALMAGIC, 4);
+  out << (quint32)JOURNALVERSION;
+  return file.flush();
+}
+
+void CacheJournal::addResource(const Resource &resource)
+{
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_0);
+  out << (quint8)RECORDRESOURCE << resource.cacheId << resource.type << resource.source
+      << resource.value << resource.timestamp;
+  append(record);
+}
+
+void CacheJournal::addRemoval(const Resource &resource)
+{
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_0);
+  out << (quint8)RECORDREMOVAL << resource.cacheId << resource.type << resource.source;
+  append(record);
+}
+
+void CacheJournal::addQuickId(const QString &filePath, const QuickId &quickId)
+{
+  QByteArray record;
+  QDataStream out(&record, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_0);
+  out << (quint8)RECORDROMINFO << filePath << quickId.timestamp << quickId.cacheId
+      << quickId.size << quickId.inode << quickId.digests << quickId.md5 << quickId.sha1
+      << quickId.crc32;
+  append(record);
+}
+
+void CacheJournal::append(const QByteArray &record)
+{
+  QMutexLocker locker(&journalMutex);
+  if(!file.isOpen()) {
+    return;
+  }
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_0);
+  out << record << qChecksum(record.constData(), record.size());
+  // Hand it to the OS right away so it survives the process being killed
+  file.flush();
+}
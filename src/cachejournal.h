@@ -0,0 +1,70 @@
+/***************************************************************************
+ *            cachejournal.h
+ *
+ *  Sat Oct 17 22:53:16 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef CACHEJOURNAL_H
+#define CACHEJOURNAL_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QPair>
+
+#include "resourcestore.h"
+
+// Append-only log of the resources and quick ids added, and the resources
+// removed, since the main cache files were last written. Each record is length prefixed and checksummed,
+// so a record torn by a crash is detected and dropped when the journal is
+// replayed. Appends are thread safe.
+class CacheJournal
+{
+public:
+  CacheJournal();
+  ~CacheJournal();
+  bool open(const QString &fileName, QList<Resource> &resources,
+	    QList<Resource> &removals, QMap<QString, QuickId> &quickIds);
+  void close();
+  bool isOpen();
+  qint64 size();
+  bool reset();
+  void addResource(const Resource &resource);
+  void addRemoval(const Resource &resource);
+  void addQuickId(const QString &filePath, const QuickId &quickId);
+
+  static bool read(const QString &fileName, QList<Resource> &resources,
+		   QList<Resource> &removals, QMap<QString, QuickId> &quickIds);
+
+private:
+  QFile file;
+  QMutex journalMutex;
+
+  void append(const QByteArray &record);
+
+  static qint64 parse(QFile &journalFile, QList<Resource> &resources,
+		      QList<Resource> &removals, QMap<QString, QuickId> &quickIds);
+};
+
+#endif // CACHEJOURNAL_H
@@ -21,48 +21,226 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
+#include <cstring>
+
 #include "crc32.h"
 
-Crc32::Crc32()
+#if defined(__ARM_FEATURE_CRC32)
+// Compiled for a cpu that is known to have the ARMv8 CRC32 instructions
+#include <arm_acle.h>
+#define CRC32_ARMV8
+#define CRC32_ARMV8_ALWAYS
+#elif defined(__aarch64__) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__)
+// Build the ARMv8 path anyway and only use it if the cpu reports support for it
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#pragma GCC push_options
+#pragma GCC target("+crc")
+#include <arm_acle.h>
+#define CRC32_ARMV8
+#elif (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+// Build the PCLMULQDQ path and only use it if the cpu reports support for it
+#include <cpuid.h>
+#include <immintrin.h>
+#define CRC32_PCLMUL
+#endif
+
+static quint32 updateSliceBy8(quint32 crc, const uchar *data, qint64 len);
+
+#ifdef CRC32_ARMV8
+static quint32 updateArmv8(quint32 crc, const uchar *data, qint64 len)
 {
-  quint32 crc;
+  while(len >= 8) {
+    quint64 value;
+    memcpy(&value, data, 8);
+    crc = __crc32d(crc, value);
+    data += 8;
+    len -= 8;
+  }
+  while(len--) {
+    crc = __crc32b(crc, *data++);
+  }
+  return crc;
+}
+#endif
 
-  // initialize CRC table
-  for (int i = 0; i < 256; i++) {
-    crc = i;
-    for (int j = 0; j < 8; j++) {
-      crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1;
-    }
-    
-    crc_table[i] = crc;
+#if defined(CRC32_ARMV8) && !defined(CRC32_ARMV8_ALWAYS)
+#pragma GCC pop_options
+#endif
+
+#ifdef CRC32_PCLMUL
+// Folds 64 bytes per step with carry-less multiplications and reduces the
+// result to 32 bits with a Barrett reduction, as described in Intel's "Fast
+// CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction". The
+// constants are powers of x modulo the bit reflected polynomial
+__attribute__((target("pclmul,sse4.1")))
+static quint32 updatePclmul(quint32 crc, const uchar *data, qint64 len)
+{
+  if(len < 64) {
+    return updateSliceBy8(crc, data, len);
+  }
+  const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+  const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+  const __m128i k5k0 = _mm_set_epi64x(0x0000000000LL, 0x0163cd6124LL);
+  const __m128i poly = _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+  __m128i x1 = _mm_loadu_si128((const __m128i *)data);
+  __m128i x2 = _mm_loadu_si128((const __m128i *)(data + 16));
+  __m128i x3 = _mm_loadu_si128((const __m128i *)(data + 32));
+  __m128i x4 = _mm_loadu_si128((const __m128i *)(data + 48));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+  data += 64;
+  len -= 64;
+
+  // Four independent folds per step keep the multipliers busy
+  while(len >= 64) {
+    __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)data));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(data + 16)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(data + 32)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(data + 48)));
+    data += 64;
+    len -= 64;
+  }
+
+  // Fold the four lanes into one, then any remaining 16 byte blocks
+  __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x5), x2);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x5), x3);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x5), x4);
+  while(len >= 16) {
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x5),
+		       _mm_loadu_si128((const __m128i *)data));
+    data += 16;
+    len -= 16;
   }
+
+  // Reduce 128 to 64 bits
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5k0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett reduction to 32 bits
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask32), poly, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  crc = _mm_extract_epi32(x1, 1);
+
+  return updateSliceBy8(crc, data, len);
 }
+#endif
+
+// Slice-by-8: 'tables[k][b]' is the CRC of byte 'b' followed by 'k' zero bytes,
+// which lets us fold in 8 bytes per step instead of one
+struct Crc32Engine {
+  quint32 tables[8][256];
+  quint32 (*update)(quint32 crc, const uchar *data, qint64 len);
+  bool hardware = false;
+
+  Crc32Engine();
+};
 
-void Crc32::initInstance(int i)
+static const Crc32Engine &engine()
 {
-  instances[i] = 0xFFFFFFFFUL;
+  // Initialized once, thread safe since C++11
+  static const Crc32Engine instance;
+  return instance;
 }
 
-void Crc32::pushData(int i, char *data, int len)
+Crc32Engine::Crc32Engine()
 {
-  quint32 crc = instances[i];
-  if(crc) {
-    for(int j = 0; j < len; j++) {
-      crc = crc_table[(crc ^ data[j]) & 0xFF] ^ (crc >> 8);
+  for(int a = 0; a < 256; ++a) {
+    quint32 crc = a;
+    for(int b = 0; b < 8; ++b) {
+      crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320UL : crc >> 1;
+    }
+    tables[0][a] = crc;
+  }
+  for(int k = 1; k < 8; ++k) {
+    for(int a = 0; a < 256; ++a) {
+      tables[k][a] = (tables[k - 1][a] >> 8) ^ tables[0][tables[k - 1][a] & 0xFF];
     }
-    
-    instances[i] = crc;
   }
+  update = updateSliceBy8;
+#if defined(CRC32_ARMV8_ALWAYS)
+  update = updateArmv8;
+  hardware = true;
+#elif defined(CRC32_ARMV8)
+  if(getauxval(AT_HWCAP) & HWCAP_CRC32) {
+    update = updateArmv8;
+    hardware = true;
+  }
+#elif defined(CRC32_PCLMUL)
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if(__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) && (ecx & bit_SSE4_1)) {
+    update = updatePclmul;
+    hardware = true;
+  }
+#endif
 }
 
-quint32 Crc32::releaseInstance(int i)
+static quint32 updateSliceBy8(quint32 crc, const uchar *data, qint64 len)
 {
-  quint32 crc32 = instances[i];
-  if (crc32) {
-    instances.remove(i);
-    return crc32 ^ 0xFFFFFFFFUL;
+  const quint32 (*tables)[256] = engine().tables;
+  while(len >= 8) {
+    quint32 one = qFromLittleEndian<quint32>(data) ^ crc;
+    quint32 two = qFromLittleEndian<quint32>(data + 4);
+    crc = tables[7][one & 0xFF] ^ tables[6][(one >> 8) & 0xFF] ^
+      tables[5][(one >> 16) & 0xFF] ^ tables[4][one >> 24] ^
+      tables[3][two & 0xFF] ^ tables[2][(two >> 8) & 0xFF] ^
+      tables[1][(two >> 16) & 0xFF] ^ tables[0][two >> 24];
+    data += 8;
+    len -= 8;
   }
-  else {
-    return 0;
+  while(len--) {
+    crc = tables[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
   }
+  return crc;
+}
+
+Crc32::Crc32()
+{
+}
+
+void Crc32::reset()
+{
+  crc = 0xFFFFFFFFUL;
+}
+
+void Crc32::pushData(const char *data, const qint64 &len)
+{
+  crc = update(crc, (const uchar *)data, len);
+}
+
+quint32 Crc32::result() const
+{
+  return crc ^ 0xFFFFFFFFUL;
+}
+
+quint32 Crc32::update(quint32 crc, const uchar *data, qint64 len)
+{
+  return engine().update(crc, data, len);
+}
+
+quint32 Crc32::updateSoftware(quint32 crc, const uchar *data, qint64 len)
+{
+  return updateSliceBy8(crc, data, len);
+}
+
+bool Crc32::isHardwareAccelerated()
+{
+  return engine().hardware;
 }
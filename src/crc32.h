@@ -25,23 +25,26 @@ SOFTWARE.
 #define CRC32_H
 
 #include <QtCore>
-#include <QString>
-#include <QMap>
 
+// Running CRC32 (the zip / zlib polynomial). The object holds nothing but the
+// running value, so use one per calculation
 class Crc32
 {
 private:
-    quint32 crc_table[256];
-    QMap<int, quint32> instances;
+    quint32 crc = 0xFFFFFFFFUL;
 
 public:
     Crc32();
 
-    quint32 calculateFromFile(QString filename);
+    void reset();
+    void pushData(const char *data, const qint64 &len);
+    quint32 result() const;
 
-    void initInstance(int i);
-    void pushData(int i, char *data, int len);
-    quint32 releaseInstance(int i);
+    // Updates a raw (non-inverted) CRC with the fastest engine this cpu supports
+    static quint32 update(quint32 crc, const uchar *data, qint64 len);
+    // Same, but always with the table based engine that works on any cpu
+    static quint32 updateSoftware(quint32 crc, const uchar *data, qint64 len);
+    static bool isHardwareAccelerated();
 };
 
 #endif // CRC32_H
@@ -0,0 +1,181 @@
+/***************************************************************************
+ *            filehasher.cpp
+ *
+ *  Sat Oct 17 23:16:40 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QFile>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QCryptographicHash>
+
+#include "filehasher.h"
+#include "crc32.h"
+
+#if defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/sysmacros.h>
+#endif
+
+// Large reads keep spinning disks and network shares streaming
+#define READBUFFERSIZE 1048576
+
+int FileHasher::defaultDigests = 0;
+QMutex FileHasher::hashesMutex;
+QMap<QString, FileHashes> FileHasher::fileHashes;
+std::function<bool(const QFileInfo &, FileHashes &)> FileHasher::loadStored;
+std::function<void(const QFileInfo &, const FileHashes &)> FileHasher::saveStored;
+
+void FileHasher::setDefaultDigests(const int &digests)
+{
+  QMutexLocker locker(&hashesMutex);
+  defaultDigests = digests;
+}
+
+int FileHasher::getDefaultDigests()
+{
+  QMutexLocker locker(&hashesMutex);
+  return defaultDigests;
+}
+
+void FileHasher::setStore(const std::function<bool(const QFileInfo &, FileHashes &)> &load,
+			  const std::function<void(const QFileInfo &, const FileHashes &)> &save)
+{
+  QMutexLocker locker(&hashesMutex);
+  loadStored = load;
+  saveStored = save;
+}
+
+quint64 FileHasher::getInode(const QFileInfo &info)
+{
+#if defined(Q_OS_UNIX)
+  struct stat fileStat;
+  if(stat(QFile::encodeName(info.absoluteFilePath()).constData(), &fileStat) == 0) {
+    return fileStat.st_ino;
+  }
+#else
+  Q_UNUSED(info);
+#endif
+  return 0;
+}
+
+bool FileHasher::isRotational(const QString &path)
+{
+#if defined(Q_OS_LINUX)
+  struct stat fileStat;
+  if(stat(QFile::encodeName(path).constData(), &fileStat) != 0) {
+    return false;
+  }
+  // Partitions don't have a 'queue' folder, so also check the disk they belong to
+  QString device = QFileInfo("/sys/dev/block/" + QString::number(major(fileStat.st_dev)) + ":" +
+			     QString::number(minor(fileStat.st_dev))).canonicalFilePath();
+  if(device.isEmpty()) {
+    return false;
+  }
+  for(const auto &queuePath: QList<QString>({device + "/queue/rotational",
+					     device + "/../queue/rotational"})) {
+    QFile rotational(queuePath);
+    if(rotational.open(QIODevice::ReadOnly)) {
+      return rotational.readAll().trimmed() == "1";
+    }
+  }
+#else
+  Q_UNUSED(path);
+#endif
+  return false;
+}
+
+FileHashes FileHasher::getHashes(const QFileInfo &info, const int &digests)
+{
+  QString filePath = info.absoluteFilePath();
+  FileHashes hashes;
+  hashes.size = info.size();
+  hashes.modified = info.lastModified().toMSecsSinceEpoch();
+
+  int wanted = digests;
+  std::function<bool(const QFileInfo &, FileHashes &)> load;
+  std::function<void(const QFileInfo &, const FileHashes &)> save;
+  {
+    QMutexLocker locker(&hashesMutex);
+    wanted |= defaultDigests;
+    load = loadStored;
+    save = saveStored;
+    QMap<QString, FileHashes>::const_iterator it = fileHashes.constFind(filePath);
+    if(it != fileHashes.constEnd() &&
+       it.value().size == hashes.size && it.value().modified == hashes.modified &&
+       (it.value().digests & digests) == digests) {
+      return it.value();
+    }
+  }
+
+  FileHashes stored;
+  if(load && load(info, stored) && (stored.digests & wanted) == wanted) {
+    QMutexLocker locker(&hashesMutex);
+    fileHashes[filePath] = stored;
+    return stored;
+  }
+
+  QFile romFile(filePath);
+  if(!romFile.open(QIODevice::ReadOnly)) {
+    return hashes;
+  }
+  QCryptographicHash md5(QCryptographicHash::Md5);
+  QCryptographicHash sha1(QCryptographicHash::Sha1);
+  Crc32 crc;
+  QByteArray buffer(READBUFFERSIZE, Qt::Uninitialized);
+  qint64 bytesRead = 0;
+  while((bytesRead = romFile.read(buffer.data(), READBUFFERSIZE)) > 0) {
+    if(wanted & MD5) {
+      md5.addData(buffer.constData(), bytesRead);
+    }
+    if(wanted & SHA1) {
+      sha1.addData(buffer.constData(), bytesRead);
+    }
+    if(wanted & CRC32) {
+      crc.pushData(buffer.constData(), bytesRead);
+    }
+  }
+  romFile.close();
+  if(bytesRead < 0) {
+    return hashes;
+  }
+
+  if(wanted & MD5) {
+    hashes.md5 = md5.result();
+  }
+  if(wanted & SHA1) {
+    hashes.sha1 = sha1.result();
+  }
+  hashes.crc32 = crc.result();
+  hashes.digests = wanted;
+
+  {
+    QMutexLocker locker(&hashesMutex);
+    fileHashes[filePath] = hashes;
+  }
+  if(save) {
+    save(info, hashes);
+  }
+  return hashes;
+}
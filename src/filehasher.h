@@ -0,0 +1,78 @@
+/***************************************************************************
+ *            filehasher.h
+ *
+ *  Sat Oct 17 23:16:40 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef FILEHASHER_H
+#define FILEHASHER_H
+
+#include <functional>
+
+#include <QMap>
+#include <QMutex>
+#include <QFileInfo>
+#include <QByteArray>
+
+struct FileHashes {
+  qint64 size = -1;
+  qint64 modified = 0;
+  int digests = 0; // Which of the digests below have been calculated. 0 means the file couldn't be read
+  QByteArray md5;
+  QByteArray sha1;
+  quint32 crc32 = 0;
+};
+
+// Calculates all the digests that are needed for a rom file in a single read
+// of the file and remembers them for the rest of the run. That way the cache id
+// and the checksums used by the scraping modules don't each read the file.
+class FileHasher
+{
+public:
+  enum Digest {
+    MD5 = 1,
+    SHA1 = 2,
+    CRC32 = 4
+  };
+  // Digests that are always calculated along with the requested ones. Set this
+  // before the run starts when it is known that a module will need them later
+  static void setDefaultDigests(const int &digests);
+  static int getDefaultDigests();
+  // Lets the resource cache hand out digests from earlier runs and keep new ones,
+  // so unchanged files are never read again
+  static void setStore(const std::function<bool(const QFileInfo &, FileHashes &)> &load,
+		       const std::function<void(const QFileInfo &, const FileHashes &)> &save);
+  static FileHashes getHashes(const QFileInfo &info, const int &digests);
+  // Returns 0 if it can't be determined, such as on Windows
+  static quint64 getInode(const QFileInfo &info);
+  // Returns true if the path is on a spinning disk. Only detected on Linux
+  static bool isRotational(const QString &path);
+
+private:
+  static int defaultDigests;
+  static std::function<bool(const QFileInfo &, FileHashes &)> loadStored;
+  static std::function<void(const QFileInfo &, const FileHashes &)> saveStored;
+  static QMutex hashesMutex;
+  static QMap<QString, FileHashes> fileHashes;
+};
+
+#endif // FILEHASHER_H
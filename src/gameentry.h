@@ -88,6 +88,8 @@ public:
   QString marqueeSrc = "";
   QByteArray videoData = "";
   QString videoFile = "";
+  QString videoTempFile = ""; // Downloaded video waiting to be moved into the cache
+  qint64 videoSize = 0;
   QString videoSrc = "";
 
   int searchMatch = 0;
@@ -0,0 +1,158 @@
+/***************************************************************************
+ *            httpcache.cpp
+ *
+ *  Sat Oct 17 23:06:50 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QUrl>
+#include <QUrlQuery>
+
+#include "httpcache.h"
+
+#define FORMATVERSION 1
+
+QMutex HttpCache::cachesMutex;
+QMap<QString, QSharedPointer<HttpCache> > HttpCache::caches;
+
+HttpCache::HttpCache(const QString &folder, const qint64 &ttl, const qint64 &maxSize)
+  : ttl(ttl), maxSize(maxSize)
+{
+  cacheDir = QDir(folder);
+}
+
+HttpCache *HttpCache::get(const QString &folder, const int &ttlHours, const int &sizeMb)
+{
+  QMutexLocker locker(&cachesMutex);
+  if(!caches.contains(folder)) {
+    caches[folder] = QSharedPointer<HttpCache>(new HttpCache(folder,
+							     (qint64)ttlHours * 60 * 60 * 1000,
+							     (qint64)sizeMb * 1024 * 1024));
+  }
+  return caches[folder].data();
+}
+
+QByteArray HttpCache::makeKey(const QString &query, const QString &postData)
+{
+  // Credentials and the order of the query items must not change the key
+  static const QList<QString> credentials({"devid", "devpassword", "ssid", "sspassword",
+					   "apikey", "api_key"});
+  QUrl url(query);
+  QList<QPair<QString, QString> > items = QUrlQuery(url).queryItems(QUrl::FullyDecoded);
+  QList<QPair<QString, QString> > keptItems;
+  for(const auto &item: items) {
+    if(!credentials.contains(item.first.toLower())) {
+      keptItems.append(item);
+    }
+  }
+  std::sort(keptItems.begin(), keptItems.end());
+  QUrlQuery normalizedQuery;
+  normalizedQuery.setQueryItems(keptItems);
+  url.setQuery(normalizedQuery);
+  url.setFragment(QString());
+  url = url.adjusted(QUrl::NormalizePathSegments | QUrl::StripTrailingSlash);
+
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(postData.isNull()?"GET\n":"POST\n");
+  hash.addData(url.toString(QUrl::FullyEncoded).toUtf8() + "\n");
+  hash.addData(postData.toUtf8());
+  return hash.result().toHex();
+}
+
+bool HttpCache::lookup(const QByteArray &key, HttpCacheEntry &entry, bool &fresh)
+{
+  QFile entryFile(cacheDir.absolutePath() + "/" + key);
+  if(!entryFile.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QDataStream in(&entryFile);
+  in.setVersion(QDataStream::Qt_5_0);
+  QByteArray magic;
+  quint32 version = 0;
+  in >> magic >> version;
+  if(magic != "SKYH" || version != FORMATVERSION) {
+    return false;
+  }
+  in >> entry.timestamp >> entry.etag >> entry.lastModified >> entry.contentType
+     >> entry.redirUrl >> entry.data;
+  if(in.status() != QDataStream::Ok) {
+    return false;
+  }
+  fresh = (QDateTime::currentMSecsSinceEpoch() - entry.timestamp < ttl);
+  return true;
+}
+
+void HttpCache::store(const QByteArray &key, HttpCacheEntry &entry)
+{
+  entry.timestamp = QDateTime::currentMSecsSinceEpoch();
+  QString fileName = cacheDir.absolutePath() + "/" + key;
+  QMutexLocker locker(&mutex);
+  if(!cacheDir.exists()) {
+    cacheDir.mkpath(cacheDir.absolutePath());
+  }
+  qint64 oldSize = QFileInfo(fileName).size();
+  QSaveFile entryFile(fileName);
+  if(!entryFile.open(QIODevice::WriteOnly)) {
+    return;
+  }
+  QDataStream out(&entryFile);
+  out.setVersion(QDataStream::Qt_5_0);
+  out << QByteArray("SKYH") << (quint32)FORMATVERSION;
+  out << entry.timestamp << entry.etag << entry.lastModified << entry.contentType
+      << entry.redirUrl << entry.data;
+  qint64 newSize = entryFile.size();
+  if(!entryFile.commit()) {
+    return;
+  }
+  if(totalSize == -1) {
+    totalSize = 0;
+    for(const auto &info: cacheDir.entryInfoList(QDir::Files)) {
+      totalSize += info.size();
+    }
+  } else {
+    totalSize += newSize - oldSize;
+  }
+  if(totalSize > maxSize) {
+    prune();
+  }
+}
+
+// Removes the least recently stored entries until we are well below 'maxSize'
+void HttpCache::prune()
+{
+  QFileInfoList entries = cacheDir.entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+  for(const auto &info: entries) {
+    if(totalSize <= maxSize - maxSize / 10) {
+      break;
+    }
+    if(QFile::remove(info.absoluteFilePath())) {
+      totalSize -= info.size();
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+ *            httpcache.h
+ *
+ *  Sat Oct 17 23:06:50 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef HTTPCACHE_H
+#define HTTPCACHE_H
+
+#include <QDir>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+
+struct HttpCacheEntry {
+  qint64 timestamp = 0;
+  QByteArray etag;
+  QByteArray lastModified;
+  QByteArray contentType;
+  QByteArray redirUrl;
+  QByteArray data;
+};
+
+// On-disk cache of scraping module api responses. Responses are stored in one
+// file each, named by a hash of the normalized request with any credentials
+// stripped. Entries older than 'ttl' are revalidated with the service when it
+// gave us an ETag or Last-Modified header, otherwise they are fetched again.
+// The oldest entries are removed once the folder grows past 'maxSize'.
+class HttpCache
+{
+public:
+  HttpCache(const QString &folder, const qint64 &ttl, const qint64 &maxSize);
+  static HttpCache *get(const QString &folder, const int &ttlHours, const int &sizeMb);
+  static QByteArray makeKey(const QString &query, const QString &postData);
+  bool lookup(const QByteArray &key, HttpCacheEntry &entry, bool &fresh);
+  void store(const QByteArray &key, HttpCacheEntry &entry);
+
+private:
+  QMutex mutex;
+  QDir cacheDir;
+  qint64 ttl;
+  qint64 maxSize;
+  qint64 totalSize = -1;
+
+  void prune();
+
+  static QMutex cachesMutex;
+  static QMap<QString, QSharedPointer<HttpCache> > caches;
+};
+
+#endif // HTTPCACHE_H
@@ -44,10 +44,11 @@ Igdb::Igdb(Settings *config,
   headers.append(clientIdHeader);
   headers.append(tokenHeader);
   
-  connect(&limitTimer, &QTimer::timeout, &limiter, &QEventLoop::quit);
-  limitTimer.setInterval(1100); // 1.1 second request limit set a bit above 1.0 as requested by the good folks at IGDB. Don't change! It will break the module stability.
-  limitTimer.setSingleShot(false);
-  limitTimer.start();
+  // 1.1 second request limit per thread set a bit above 1.0 as requested by the good folks at IGDB. Don't change! It will break the module stability.
+  rateLimiter = RateLimiter::get("igdb", 1100 / qMax(config->threads, 1), config->threads);
+  netComm->setRateLimiter(rateLimiter);
+  // Threads wait up to one request slot for others to share the game data request with
+  batcher = ApiBatcher::get("igdb", qMin(config->threads, 500), 1100 / qMax(config->threads, 1));
 
   baseUrl = "https://api.igdb.com/v4";
 
@@ -67,7 +68,6 @@ void Igdb::getSearchResults(QList<GameEntry> &gameEntries,
 				QString searchName, QString platform)
 {
   // Request list of games but don't allow re-releases ("game.version_parent = null")
-  limiter.exec();
   netComm->request(baseUrl + "/search/", "fields game.name,game.platforms.name; search \"" + searchName + "\"; where game != null & game.version_parent = null;", headers);
   q.exec();
   data = netComm->getData();
@@ -104,17 +104,25 @@ void Igdb::getSearchResults(QList<GameEntry> &gameEntries,
 
 void Igdb::getGameData(GameEntry &game)
 {
-  limiter.exec();
-  netComm->request(baseUrl + "/games/", "fields age_ratings.rating,age_ratings.category,total_rating,cover.url,game_modes.slug,genres.name,screenshots.url,summary,release_dates.date,release_dates.region,release_dates.platform,involved_companies.company.name,involved_companies.developer,involved_companies.publisher; where id = " + game.id.split(";").first() + ";", headers);
-  q.exec();
-  data = netComm->getData();
+  QString gameId = game.id.split(";").first();
+  data = batcher->fetch(gameId, [this](const QStringList &ids) -> QByteArray {
+      netComm->request(baseUrl + "/games/", "fields age_ratings.rating,age_ratings.category,total_rating,cover.url,game_modes.slug,genres.name,screenshots.url,summary,release_dates.date,release_dates.region,release_dates.platform,involved_companies.company.name,involved_companies.developer,involved_companies.publisher; where id = (" + ids.join(",") + "); limit " + QString::number(ids.length()) + ";", headers);
+      q.exec();
+      return netComm->getData();
+    });
 
   jsonDoc = QJsonDocument::fromJson(data);
   if(jsonDoc.isEmpty()) {
     return;
   }
 
-  jsonObj = jsonDoc.array().first().toObject();
+  jsonObj = QJsonObject();
+  for(const auto &jsonGame: jsonDoc.array()) {
+    if(QString::number(jsonGame.toObject()["id"].toInt()) == gameId) {
+      jsonObj = jsonGame.toObject();
+      break;
+    }
+  }
 
   for(int a = 0; a < fetchOrder.length(); ++a) {
     switch(fetchOrder.at(a)) {
@@ -156,6 +164,7 @@ void Igdb::getGameData(GameEntry &game)
       ;
     }
   }
+  fetchMedia();
 }
 
 void Igdb::getReleaseDate(GameEntry &game)
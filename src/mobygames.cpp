@@ -36,10 +36,8 @@ MobyGames::MobyGames(Settings *config,
 		     QSharedPointer<NetManager> manager)
   : AbstractScraper(config, manager)
 {
-  connect(&limitTimer, &QTimer::timeout, &limiter, &QEventLoop::quit);
-  limitTimer.setInterval(10000); // 10 second request limit
-  limitTimer.setSingleShot(false);
-  limitTimer.start();
+  // 10 second request limit. Only the api requests are limited, not the media downloads
+  rateLimiter = RateLimiter::get("mobygames", 10000, 1);
 
   baseUrl = "https://api.mobygames.com";
 
@@ -63,9 +61,10 @@ void MobyGames::getSearchResults(QList<GameEntry> &gameEntries,
   QString platformId = getPlatformId(config->platform);
 
   printf("Waiting as advised by MobyGames api restrictions...\n");
-  limiter.exec();
+  rateLimiter->acquire();
   netComm->request(searchUrlPre + "?api_key=" + StrTools::unMagic("175;229;170;189;188;202;211;117;164;165;185;209;164;234;180;155;199;209;224;231;193;190;173;175") + "&title=" + searchName + (platformId == "na"?"":"&platform=" + platformId));
   q.exec();
+  rateLimiter->release();
   data = netComm->getData();
 
   jsonDoc = QJsonDocument::fromJson(data);
@@ -106,9 +105,10 @@ void MobyGames::getSearchResults(QList<GameEntry> &gameEntries,
 void MobyGames::getGameData(GameEntry &game)
 {
   printf("Waiting to get game data...\n");
-  limiter.exec();
+  rateLimiter->acquire();
   netComm->request(game.url);
   q.exec();
+  rateLimiter->release();
   data = netComm->getData();
 
   jsonDoc = QJsonDocument::fromJson(data);
@@ -158,6 +158,7 @@ void MobyGames::getGameData(GameEntry &game)
       ;
     }
   }
+  fetchMedia();
 }
 
 void MobyGames::getReleaseDate(GameEntry &game)
@@ -293,9 +294,10 @@ void MobyGames::getRating(GameEntry &game)
 void MobyGames::getCover(GameEntry &game)
 {
   printf("Waiting to get cover data...\n");
-  limiter.exec();
+  rateLimiter->acquire();
   netComm->request(game.url.left(game.url.indexOf("?api_key=")) + "/covers" + game.url.mid(game.url.indexOf("?api_key="), game.url.length() - game.url.indexOf("?api_key=")));
   q.exec();
+  rateLimiter->release();
   data = netComm->getData();
 
   jsonDoc = QJsonDocument::fromJson(data);
@@ -345,22 +347,25 @@ void MobyGames::getCover(GameEntry &game)
   coverUrl.replace("http://", "https://"); // For some reason the links are http but they are always redirected to https
 
   if(!coverUrl.isEmpty()) {
-    netComm->request(coverUrl);
-    q.exec();
-    QImage image;
-    if(netComm->getError() == QNetworkReply::NoError &&
-       image.loadFromData(netComm->getData())) {
-      game.coverData = netComm->getData();
-    }
+    queueMedia({coverUrl}, [&game](const NetResult &result) {
+	QImage image;
+	if(result.getError() == QNetworkReply::NoError &&
+	   image.loadFromData(result.getData())) {
+	  game.coverData = result.getData();
+	  return true;
+	}
+	return false;
+      });
   }
 }
 
 void MobyGames::getScreenshot(GameEntry &game)
 {
   printf("Waiting to get screenshot data...\n");
-  limiter.exec();
+  rateLimiter->acquire();
   netComm->request(game.url.left(game.url.indexOf("?api_key=")) + "/screenshots" + game.url.mid(game.url.indexOf("?api_key="), game.url.length() - game.url.indexOf("?api_key=")));
   q.exec();
+  rateLimiter->release();
   data = netComm->getData();
 
   jsonDoc = QJsonDocument::fromJson(data);
@@ -382,13 +387,15 @@ void MobyGames::getScreenshot(GameEntry &game)
     chosen = (qrand() % jsonScreenshots.count() - 3) + 3;
 #endif
   }
-  netComm->request(jsonScreenshots.at(chosen).toObject()["image"].toString().replace("http://", "https://"));
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.screenshotData = netComm->getData();
-  }
+  queueMedia({jsonScreenshots.at(chosen).toObject()["image"].toString().replace("http://", "https://")}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.screenshotData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 QString MobyGames::getPlatformId(const QString platform)
@@ -25,6 +25,7 @@
 
 #include "nametools.h"
 #include "strtools.h"
+#include "filehasher.h"
 
 #include <QFileInfo>
 #include <QDir>
@@ -514,16 +515,12 @@ QString NameTools::getCacheId(const QFileInfo &info)
     cacheIdFromData = false;
   }
   if(cacheIdFromData) {
-    QFile romFile(info.absoluteFilePath());
-    if(romFile.open(QIODevice::ReadOnly)) {
-      while(!romFile.atEnd()) {
-	cacheId.addData(romFile.read(1024));
-      }
-      romFile.close();
-    } else {
+    FileHashes hashes = FileHasher::getHashes(info, FileHasher::SHA1);
+    if(hashes.digests == 0) {
       printf("Couldn't calculate cache id of rom file '%s', please check permissions and try again, now exiting...\n", info.fileName().toStdString().c_str());
       exit(1);
     }
+    return hashes.sha1.toHex();
   } else {
     cacheId.addData(info.fileName().toUtf8());
   }
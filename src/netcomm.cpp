@@ -25,20 +25,62 @@
 
 #include "netcomm.h"
 
+#include <QDir>
 #include <QUrl>
 #include <QNetworkRequest>
+#include <QTemporaryFile>
 
 constexpr int MAXSIZE = 100*1024*1024;
+constexpr int REQUESTTIMEOUT = 30000;
 
 NetComm::NetComm(QSharedPointer<NetManager> manager)
   : manager(manager)
 {
-  requestTimer.setSingleShot(true);
-  requestTimer.setInterval(30000);
-  connect(&requestTimer, &QTimer::timeout, this, &NetComm::requestTimeout);
 }
 
-void NetComm::request(QString query, QString postData, QList<QPair<QString, QString> > headers)
+NetComm::~NetComm()
+{
+  // Callbacks might refer to objects that are gone by now, so drop them unanswered
+  for(auto *reply: replies) {
+    disconnect(reply, nullptr, this, nullptr);
+    reply->abort();
+    QFile *file = reply->findChild<QFile *>();
+    if(file != nullptr) {
+      file->remove();
+    }
+    reply->deleteLater();
+    if(limiter != nullptr) {
+      limiter->release();
+    }
+  }
+}
+
+void NetComm::requestAsync(QString query, std::function<void(const NetResult &)> callback,
+			   QString postData, QList<QPair<QString, QString> > headers)
+{
+  sendRequest(query, postData, headers, nullptr, MAXSIZE, callback);
+}
+
+void NetComm::requestToFile(QString query, const QString &folder, const qint64 &maxSize,
+			    std::function<void(const NetResult &)> callback)
+{
+  QDir().mkpath(folder);
+  QTemporaryFile *file = new QTemporaryFile(folder + "/.download_XXXXXX");
+  // The file is moved into place by whoever gets the result, so don't remove it
+  file->setAutoRemove(false);
+  if(!file->open()) {
+    delete file;
+    NetResult result;
+    result.error = QNetworkReply::UnknownContentError;
+    callback(result);
+    return;
+  }
+  sendRequest(query, QString(), QList<QPair<QString, QString> >(), file, maxSize, callback);
+}
+
+void NetComm::sendRequest(const QString &query, const QString &postData,
+			  const QList<QPair<QString, QString> > &headers, QFile *file,
+			  const qint64 &maxSize, std::function<void(const NetResult &)> callback)
 {
   QUrl url(query);
   QNetworkRequest request(url);
@@ -51,33 +93,217 @@ void NetComm::request(QString query, QString postData, QList<QPair<QString, QStr
     }
   }
 
+  if(limiter != nullptr) {
+    limiter->acquire();
+  }
+  QNetworkReply *reply;
   if(postData.isNull()) {
     reply = manager->getRequest(request);
   } else {
     reply = manager->postRequest(request, postData.toUtf8());
   }
-  connect(reply, &QNetworkReply::finished, this, &NetComm::replyReady);
-  connect(reply, &QNetworkReply::downloadProgress, this, &NetComm::dataDownloaded);
-  requestTimer.start();
+  replies.insert(reply);
+
+  // The timer and the file are children of the reply, so they go away together with it
+  QTimer *requestTimer = new QTimer(reply);
+  requestTimer->setSingleShot(true);
+  connect(requestTimer, &QTimer::timeout, reply, [reply]() {
+      printf("\033[1;33mRequest timed out, server might be busy / overloaded...\033[0m\n");
+      reply->setProperty("timedOut", true);
+      reply->abort();
+    });
+  if(file != nullptr) {
+    file->setParent(reply);
+    // Give up as soon as the headers tell us it's too large instead of after downloading it
+    connect(reply, &QNetworkReply::metaDataChanged, reply, [reply, maxSize]() {
+	if(reply->header(QNetworkRequest::ContentLengthHeader).toLongLong() > maxSize) {
+	  reply->setProperty("sizeExceeded", true);
+	  reply->abort();
+	}
+      });
+    connect(reply, &QNetworkReply::readyRead, reply, [reply, file]() {
+	file->write(reply->readAll());
+      });
+  }
+  connect(reply, &QNetworkReply::downloadProgress, reply, [reply, file, maxSize](qint64 bytesReceived, qint64) {
+      if(bytesReceived > maxSize) {
+	if(file == nullptr) {
+	  printf("Retrieved data size exceeded maximum of 100 MB, cancelling network request...\n");
+	}
+	reply->setProperty("sizeExceeded", true);
+	reply->abort();
+      }
+    });
+  connect(reply, &QNetworkReply::finished, this, [this, reply, requestTimer, file, callback]() {
+      requestTimer->stop();
+      replies.remove(reply);
+      if(limiter != nullptr) {
+	limiter->release();
+      }
+      NetResult result;
+      result.error = reply->error();
+      if(reply->property("timedOut").toBool()) {
+	result.error = QNetworkReply::TimeoutError;
+      }
+      result.contentType = reply->rawHeader("Content-Type");
+      result.redirUrl = reply->rawHeader("Location");
+      result.statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+      result.etag = reply->rawHeader("ETag");
+      result.lastModified = reply->rawHeader("Last-Modified");
+      result.sizeExceeded = reply->property("sizeExceeded").toBool();
+      if(file != nullptr) {
+	file->write(reply->readAll());
+	result.size = file->size();
+	file->close();
+	if(result.error == QNetworkReply::NoError) {
+	  result.fileName = file->fileName();
+	} else {
+	  file->remove();
+	}
+	if(result.sizeExceeded) {
+	  result.size = qMax(result.size, reply->header(QNetworkRequest::ContentLengthHeader).toLongLong());
+	}
+      } else {
+	result.data = reply->readAll();
+	result.size = result.data.size();
+      }
+      reply->deleteLater();
+      callback(result);
+    });
+  requestTimer->start(REQUESTTIMEOUT);
+}
+
+void NetComm::request(QString query, QString postData, QList<QPair<QString, QString> > headers)
+{
+  fromCache = false;
+  if(httpCache == nullptr) {
+    requestAsync(query, [this](const NetResult &reply) {
+	result = reply;
+	emit dataReady();
+      }, postData, headers);
+    return;
+  }
+
+  QByteArray key = HttpCache::makeKey(query, postData);
+  HttpCacheEntry entry;
+  bool fresh = false;
+  bool cached = httpCache->lookup(key, entry, fresh);
+  if(cached && cacheValidator && !cacheValidator(entry.data)) {
+    // Stored before it was rejected, never replay it
+    cached = false;
+  }
+  if(cached && fresh) {
+    fromCache = true;
+    result = NetResult();
+    result.data = entry.data;
+    result.contentType = entry.contentType;
+    result.redirUrl = entry.redirUrl;
+    result.statusCode = 200;
+    // Callers only start waiting for 'dataReady' once we return
+    QTimer::singleShot(0, this, &NetComm::dataReady);
+    return;
+  }
+  if(cached) {
+    if(!entry.etag.isEmpty()) {
+      headers.append(QPair<QString, QString>("If-None-Match", entry.etag));
+    }
+    if(!entry.lastModified.isEmpty()) {
+      headers.append(QPair<QString, QString>("If-Modified-Since", entry.lastModified));
+    }
+  }
+  requestAsync(query, [this, key, cached, entry](const NetResult &reply) mutable {
+      if(cached && reply.statusCode == 304) {
+	// Still valid, so keep using the cached response for another ttl
+	httpCache->store(key, entry);
+	fromCache = true;
+	result = NetResult();
+	result.data = entry.data;
+	result.contentType = entry.contentType;
+	result.redirUrl = entry.redirUrl;
+	result.statusCode = 200;
+      } else {
+	result = reply;
+	if(reply.error == QNetworkReply::NoError && reply.statusCode == 200 &&
+	   !reply.data.isEmpty() && (!cacheValidator || cacheValidator(reply.data))) {
+	  HttpCacheEntry newEntry;
+	  newEntry.etag = reply.etag;
+	  newEntry.lastModified = reply.lastModified;
+	  newEntry.contentType = reply.contentType;
+	  newEntry.redirUrl = reply.redirUrl;
+	  newEntry.data = reply.data;
+	  httpCache->store(key, newEntry);
+	}
+      }
+      emit dataReady();
+    }, postData, headers);
+}
+
+int NetComm::pendingRequests() const
+{
+  return replies.size();
+}
+
+void NetComm::setRateLimiter(RateLimiter *limiter)
+{
+  this->limiter = limiter;
+}
+
+void NetComm::setHttpCache(HttpCache *httpCache)
+{
+  this->httpCache = httpCache;
 }
 
-void NetComm::replyReady()
+void NetComm::setCacheValidator(std::function<bool(const QByteArray &)> validator)
 {
-  requestTimer.stop();
-  data = reply->readAll();
-  error = reply->error();
-  contentType = reply->rawHeader("Content-Type");;
-  redirUrl = reply->rawHeader("Location");
-  reply->deleteLater();
-  emit dataReady();
+  cacheValidator = validator;
+}
+
+bool NetComm::isFromCache()
+{
+  return fromCache;
 }
 
 QByteArray NetComm::getData()
 {
-  return data;
+  return result.getData();
 }
 
 QNetworkReply::NetworkError NetComm::getError(const int &verbosity)
+{
+  return result.getError(verbosity);
+}
+
+QByteArray NetComm::getContentType()
+{
+  return result.getContentType();
+}
+
+QByteArray NetComm::getRedirUrl()
+{
+  return result.getRedirUrl();
+}
+
+QByteArray NetResult::getData() const
+{
+  return data;
+}
+
+QString NetResult::getFileName() const
+{
+  return fileName;
+}
+
+qint64 NetResult::getSize() const
+{
+  return size;
+}
+
+bool NetResult::isSizeExceeded() const
+{
+  return sizeExceeded;
+}
+
+QNetworkReply::NetworkError NetResult::getError(const int &verbosity) const
 {
   if(error != QNetworkReply::NoError && verbosity >= 1) {
     switch(error) {
@@ -123,26 +349,12 @@ QNetworkReply::NetworkError NetComm::getError(const int &verbosity)
   return error;
 }
 
-QByteArray NetComm::getContentType()
+QByteArray NetResult::getContentType() const
 {
   return contentType;
 }
 
-QByteArray NetComm::getRedirUrl()
+QByteArray NetResult::getRedirUrl() const
 {
   return redirUrl;
 }
-
-void NetComm::dataDownloaded(qint64 bytesReceived, qint64)
-{
-  if(bytesReceived > MAXSIZE) {
-    printf("Retrieved data size exceeded maximum of 100 MB, cancelling network request...\n");
-    reply->abort();
-  }
-}
-
-void NetComm::requestTimeout()
-{ 
-  printf("\033[1;33mRequest timed out, server might be busy / overloaded...\033[0m\n");
-  reply->abort();
-}
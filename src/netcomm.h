@@ -27,38 +27,90 @@
 #define NETCOMM_H
 
 #include "netmanager.h"
+#include "ratelimiter.h"
+#include "httpcache.h"
 
+#include <QFile>
 #include <QNetworkReply>
+#include <QSet>
 #include <QTimer>
 
+#include <functional>
+
+// Everything we keep from a finished request
+class NetResult
+{
+public:
+  QByteArray getData() const;
+  QString getFileName() const;
+  qint64 getSize() const;
+  bool isSizeExceeded() const;
+  QNetworkReply::NetworkError getError(const int &verbosity = 0) const;
+  QByteArray getContentType() const;
+  QByteArray getRedirUrl() const;
+
+  QByteArray data;
+  QNetworkReply::NetworkError error = QNetworkReply::NoError;
+  QByteArray contentType;
+  QByteArray redirUrl;
+  int statusCode = 0;
+  QByteArray etag;
+  QByteArray lastModified;
+  QString fileName; // Only set for 'requestToFile'
+  qint64 size = 0;
+  bool sizeExceeded = false;
+};
+
 class NetComm : public QObject
 {
   Q_OBJECT
 
 public:
   NetComm(QSharedPointer<NetManager> manager);
+  ~NetComm();
+  // Sends the request and returns right away. Any number of requests can be in
+  // flight at once, each with its own timeout, and 'callback' is called with the
+  // result when the request finishes
+  void requestAsync(QString query, std::function<void(const NetResult &)> callback,
+		    QString postData = QString(), QList<QPair<QString, QString> > headers = QList<QPair<QString, QString> >());
+  // Like 'requestAsync' but the body is written to a temporary file in 'folder'
+  // as it arrives instead of being kept in memory. The request is cancelled as
+  // soon as it is known to be larger than 'maxSize'
+  void requestToFile(QString query, const QString &folder, const qint64 &maxSize,
+		     std::function<void(const NetResult &)> callback);
+  // Blocking style wrapper around 'requestAsync'. Emits 'dataReady' when done
+  // after which the result can be read with the getters below. This is the one
+  // used for api calls, so it is answered from the http cache when one is set
   void request(QString query, QString postData = QString(), QList<QPair<QString, QString> > headers = QList<QPair<QString, QString> >());
+  int pendingRequests() const;
+  // Every request sent after this waits for its turn with 'limiter'
+  void setRateLimiter(RateLimiter *limiter);
+  void setHttpCache(HttpCache *httpCache);
+  // Only bodies accepted by 'validator' are stored in or replayed from the http
+  // cache. Lets a module keep error and busy messages sent as '200 OK' out of it
+  void setCacheValidator(std::function<bool(const QByteArray &)> validator);
+  // True if the last 'request' was answered from the http cache
+  bool isFromCache();
   QByteArray getData();
   QNetworkReply::NetworkError getError(const int &verbosity = 0);
   QByteArray getContentType();
   QByteArray getRedirUrl();
 
-private slots:
-  void replyReady();
-  void dataDownloaded(qint64 bytesReceived, qint64);
-  void requestTimeout();
-
 signals:
   void dataReady();
 
 private:
+  void sendRequest(const QString &query, const QString &postData,
+		   const QList<QPair<QString, QString> > &headers, QFile *file,
+		   const qint64 &maxSize, std::function<void(const NetResult &)> callback);
+
   QSharedPointer<NetManager> manager;
-  QTimer requestTimer;
-  QByteArray data;
-  QNetworkReply::NetworkError error;
-  QByteArray contentType;
-  QByteArray redirUrl;
-  QNetworkReply *reply;
+  QSet<QNetworkReply *> replies;
+  RateLimiter *limiter = nullptr;
+  HttpCache *httpCache = nullptr;
+  std::function<bool(const QByteArray &)> cacheValidator;
+  NetResult result;
+  bool fromCache = false;
 };
 
 #endif // NETCOMM_H
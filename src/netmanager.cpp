@@ -27,18 +27,45 @@
 
 #include <QNetworkRequest>
 
+QAtomicInt NetManager::requests;
+QAtomicInt NetManager::tlsHandshakes;
+
 NetManager::NetManager()
 {
+#ifndef QT_NO_SSL
+  // Only emitted when a new connection is set up, not when one is reused
+  connect(this, &QNetworkAccessManager::encrypted, [](QNetworkReply *) {
+      tlsHandshakes.fetchAndAddRelaxed(1);
+    });
+#endif
 }
 
-QNetworkReply *NetManager::getRequest(const QNetworkRequest &request)
+void NetManager::prepare(QNetworkRequest &request)
 {
-  QMutexLocker locker(&requestMutex);
+#if QT_VERSION >= 0x050800
+  request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#endif
+  requests.fetchAndAddRelaxed(1);
+}
+
+QNetworkReply *NetManager::getRequest(QNetworkRequest request)
+{
+  prepare(request);
   return get(request);
 }
 
-QNetworkReply *NetManager::postRequest(const QNetworkRequest &request, const QByteArray &data)
+QNetworkReply *NetManager::postRequest(QNetworkRequest request, const QByteArray &data)
 {
-  QMutexLocker locker(&requestMutex);
+  prepare(request);
   return post(request, data);
 }
+
+int NetManager::getRequests()
+{
+  return requests.load();
+}
+
+int NetManager::getTlsHandshakes()
+{
+  return tlsHandshakes.load();
+}
@@ -28,18 +28,26 @@
 
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
-#include <QMutex>
+#include <QAtomicInt>
 
+// Each scraping thread creates its own NetManager, so connections are kept
+// alive and reused (and multiplexed with HTTP/2 where the server supports it)
+// per thread without any locking between threads
 class NetManager : public QNetworkAccessManager
 {
   Q_OBJECT
 
 public:
   NetManager();
-  QNetworkReply *getRequest(const QNetworkRequest &request);
-  QNetworkReply *postRequest(const QNetworkRequest &request, const QByteArray &data);
+  QNetworkReply *getRequest(QNetworkRequest request);
+  QNetworkReply *postRequest(QNetworkRequest request, const QByteArray &data);
+  static int getRequests();
+  static int getTlsHandshakes();
 
 private:
-  QMutex requestMutex;
+  void prepare(QNetworkRequest &request);
+
+  static QAtomicInt requests;
+  static QAtomicInt tlsHandshakes;
 };
 #endif // NETMANAGER_H
@@ -206,6 +206,7 @@ void OpenRetro::getGameData(GameEntry &game)
       ;
     }
   }
+  fetchMedia();
 }
 
 void OpenRetro::getDescription(GameEntry &game)
@@ -276,13 +277,15 @@ void OpenRetro::getCover(GameEntry &game)
   if(coverUrl.left(4) != "http") {
     coverUrl.prepend(baseUrl + (coverUrl.left(1) == "/"?"":"/"));
   }
-  netComm->request(coverUrl);
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.coverData = netComm->getData();
-  }
+  queueMedia({coverUrl}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.coverData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void OpenRetro::getMarquee(GameEntry &game)
@@ -302,13 +305,15 @@ void OpenRetro::getMarquee(GameEntry &game)
   if(marqueeUrl.left(4) != "http") {
     marqueeUrl.prepend(baseUrl + (marqueeUrl.left(1) == "/"?"":"/"));
   }
-  netComm->request(marqueeUrl);
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.marqueeData = netComm->getData();
-  }
+  queueMedia({marqueeUrl}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.marqueeData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 QList<QString> OpenRetro::getSearchNames(const QFileInfo &info)
@@ -0,0 +1,334 @@
+/***************************************************************************
+ *            pipeline.cpp
+ *
+ *  Sat Oct 17 23:13:51 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QtConcurrent>
+#include <QRegularExpression>
+#include <QDate>
+#include <QElapsedTimer>
+
+#include "pipeline.h"
+#include "nametools.h"
+#include "strtools.h"
+#include "filehasher.h"
+
+Pipeline::Pipeline(QSharedPointer<Queue> queue, QSharedPointer<Cache> cache,
+		   const Settings &config)
+  : queue(queue), cache(cache), config(config),
+    scraperThreads(config.threads),
+    hashThreads(QThread::idealThreadCount()),
+    processThreads(QThread::idealThreadCount()),
+    hashedJobs(scraperThreads * 2), scrapedJobs(processThreads * 2)
+{
+}
+
+Pipeline::~Pipeline()
+{
+  hashedJobs.close();
+  scrapedJobs.close();
+  hashPool.waitForDone();
+  processPool.waitForDone();
+  for(const auto thread: threadList) {
+    thread->quit();
+    thread->wait();
+    delete thread;
+  }
+}
+
+int Pipeline::getScraperThreads()
+{
+  return scraperThreads;
+}
+
+int Pipeline::getHashThreads()
+{
+  return hashThreads;
+}
+
+int Pipeline::getProcessThreads()
+{
+  return processThreads;
+}
+
+void Pipeline::prehash()
+{
+  int totalFiles = queue->length();
+  int threads = config.prehashThreads;
+  if(threads <= 0) {
+    threads = QThread::idealThreadCount();
+    // Parallel reads make a spinning disk seek back and forth between files,
+    // which is a lot slower than reading them one at a time
+    if(FileHasher::isRotational(config.inputFolder)) {
+      threads = 1;
+    }
+  }
+  threads = qMax(qMin(threads, totalFiles), 1);
+  printf("Prehashing \033[1;32m%d\033[0m files using \033[1;32m%d\033[0m threads... ", totalFiles, threads);
+  fflush(stdout);
+
+  QElapsedTimer prehashTimer;
+  prehashTimer.start();
+  // Module checksums might also be missing for files that already have a cache id
+  bool checksums = (FileHasher::getDefaultDigests() != 0);
+  QAtomicInt next = 0;
+  QAtomicInt hashed = 0;
+  QThreadPool prehashPool;
+  prehashPool.setMaxThreadCount(threads);
+  for(int a = 0; a < threads; ++a) {
+    QtConcurrent::run(&prehashPool, [this, &next, &hashed, totalFiles, checksums]() {
+	int index = 0;
+	while((index = next.fetchAndAddOrdered(1)) < totalFiles) {
+	  const QFileInfo &info = queue->at(index);
+	  if(cache->getQuickId(info).isEmpty()) {
+	    cache->addQuickId(info, NameTools::getCacheId(info));
+	    hashed.fetchAndAddOrdered(1);
+	  } else if(checksums) {
+	    FileHasher::getHashes(info, 0);
+	  }
+	}
+      });
+  }
+  prehashPool.waitForDone();
+  printf("\033[1;32mDone!\033[0m (%d new cache ids in %.1f seconds)\n\n", hashed.loadAcquire(), prehashTimer.elapsed() / 1000.0);
+}
+
+void Pipeline::start(const int &totalFiles)
+{
+  // Do not start more threads than we have files for
+  scraperThreads = qMax(qMin(scraperThreads, totalFiles), 1);
+  hashThreads = qMax(qMin(hashThreads, totalFiles), 1);
+  processThreads = qMax(qMin(processThreads, totalFiles), 1);
+  hashersLeft = hashThreads;
+  scrapersLeft = scraperThreads;
+  processorsLeft = processThreads;
+
+  hashPool.setMaxThreadCount(hashThreads);
+  for(int a = 0; a < hashThreads; ++a) {
+    QtConcurrent::run(&hashPool, [this]() { hashFiles(); });
+  }
+  processPool.setMaxThreadCount(processThreads);
+  for(int a = 0; a < processThreads; ++a) {
+    QtConcurrent::run(&processPool, [this]() { processEntries(); });
+  }
+  for(int curThread = 1; curThread <= scraperThreads; ++curThread) {
+    QThread *thread = new QThread;
+    ScraperWorker *worker = new ScraperWorker(&hashedJobs, &scrapedJobs, cache, config,
+					      QString::number(curThread));
+    worker->moveToThread(thread);
+    connect(thread, &QThread::started, worker, &ScraperWorker::run);
+    connect(worker, &ScraperWorker::allDone, this, &Pipeline::scraperDone);
+    connect(thread, &QThread::finished, worker, &ScraperWorker::deleteLater);
+    threadList.append(thread);
+  }
+  // Ready, set, GO! Start all threads
+  for(const auto thread: threadList) {
+    thread->start();
+  }
+}
+
+void Pipeline::hashFiles()
+{
+  QFileInfo info;
+  while(queue->takeEntry(info)) {
+    ScrapeJob job;
+    job.info = info;
+    job.cacheId = cache->getQuickId(job.info);
+    if(job.cacheId.isEmpty()) {
+      job.cacheId = NameTools::getCacheId(job.info);
+      cache->addQuickId(job.info, job.cacheId);
+    }
+    // Fails if the scraping threads have all stopped
+    if(!hashedJobs.push(job)) {
+      break;
+    }
+  }
+  if(hashersLeft.fetchAndAddOrdered(-1) == 1) {
+    hashedJobs.close();
+  }
+}
+
+void Pipeline::scraperDone()
+{
+  if(scrapersLeft.fetchAndAddOrdered(-1) != 1) {
+    return;
+  }
+  // If the threads stopped early (request limit reached) there might still be
+  // files waiting to be hashed. Drop those and let the hashing threads exit
+  queue->clearAll();
+  hashedJobs.close();
+  scrapedJobs.close();
+}
+
+void Pipeline::processEntries()
+{
+  Settings config = this->config;
+  Compositor compositor(&config);
+  if(!compositor.processXml()) {
+    printf("Something went wrong when parsing artwork xml from '%s', please check the file for errors. Now exiting...\n", config.artworkConfig.toStdString().c_str());
+    exit(1);
+  }
+
+  ScrapeJob job;
+  while(scrapedJobs.pop(job)) {
+    if(!job.done) {
+      processEntry(job, compositor, config);
+    }
+    emit entryReady(job.game, job.output, job.debug);
+  }
+  if(processorsLeft.fetchAndAddOrdered(-1) == 1) {
+    emit allDone();
+  }
+}
+
+void Pipeline::processEntry(ScrapeJob &job, Compositor &compositor, Settings &config)
+{
+  GameEntry &game = job.game;
+  const QFileInfo &info = job.info;
+  const QString &compareTitle = job.compareTitle;
+  const bool &fromCache = job.fromCache;
+  const int &searchMatch = job.searchMatch;
+  QString &output = job.output;
+
+  if(!config.pretend && config.scraper == "cache") {
+    // Process all artwork
+    compositor.saveAll(game, info.completeBaseName());
+    // Copy or symlink videos as requested
+    if(config.videos &&
+       game.videoFormat != "" &&
+       !game.videoFile.isEmpty() &&
+       QFile::exists(game.videoFile)) {
+      QString videoDst = config.videosFolder + "/" + info.completeBaseName() + "." + game.videoFormat;
+      if(config.skipExistingVideos && QFile::exists(videoDst)) {
+      } else {
+	if(QFile::exists(videoDst)) {
+	  QFile::remove(videoDst);
+	}
+	if(config.symlink) {
+	  // Try to remove existing video destination file before linking
+	  if(!QFile::link(game.videoFile, videoDst)) {
+	    game.videoFormat = "";
+	  }
+	} else {
+	  if(!QFile::copy(game.videoFile, videoDst)) {
+	    game.videoFormat = "";
+	  }
+	}
+      }
+    }
+  }
+
+  // Add all resources to the cache
+  QString cacheOutput = "";
+  if(config.scraper != "cache" && game.found && !fromCache) {
+    game.source = config.scraper;
+    cache->addResources(game, config, cacheOutput);
+  }
+
+  // We're done saving the raw data at this point, so feel free to manipulate game resources to better suit game list creation from here on out.
+
+  // Strip any brackets from the title as they will be readded when assembling gamelist
+  game.title = StrTools::stripBrackets(game.title);
+
+  // Move 'The' or ', The' depending on the config. This does not affect game list sorting. 'The ' is always removed before sorting.
+  if(config.theInFront) {
+    QRegularExpression theMatch(", [Tt]{1}he");
+    if(theMatch.match(game.title).hasMatch()) {
+      game.title.replace(theMatch.match(game.title).captured(0), "");
+      game.title.prepend("The ");
+    }
+  } else {
+    if(game.title.toLower().left(4) == "the ") {
+      game.title = game.title.remove(0, 4).simplified().append(", The");
+    }
+  }
+
+  // Don't unescape title since we already did that in getBestEntry()
+  game.videoFile = StrTools::xmlUnescape(config.videosFolder + "/" + info.completeBaseName() + "." + game.videoFormat);
+  game.description = StrTools::xmlUnescape(game.description);
+  game.releaseDate = StrTools::xmlUnescape(game.releaseDate);
+  // Make sure we have the correct 'yyyymmdd' format of 'releaseDate'
+  game.releaseDate = StrTools::conformReleaseDate(game.releaseDate);
+  game.developer = StrTools::xmlUnescape(game.developer);
+  game.publisher = StrTools::xmlUnescape(game.publisher);
+  game.tags = StrTools::xmlUnescape(game.tags);
+  game.tags = StrTools::conformTags(game.tags);
+  game.rating = StrTools::xmlUnescape(game.rating);
+  game.players = StrTools::xmlUnescape(game.players);
+  // Make sure we have the correct single digit format of 'players'
+  game.players = StrTools::conformPlayers(game.players);
+  game.ages = StrTools::xmlUnescape(game.ages);
+  // Make sure we have the correct format of 'ages'
+  game.ages = StrTools::conformAges(game.ages);
+
+  output.append("Scraper:        " + config.scraper + "\n");
+  output.append(job.rateLimit);
+  if(config.scraper != "cache" && config.scraper != "import") {
+    output.append("From cache:     " + QString((fromCache?"YES (refresh from source with '--cache refresh')":"NO")) + "\n");
+    output.append("Search match:   " + QString::number(searchMatch) + " %\n");
+    output.append("Compare title:  '\033[1;32m" + compareTitle + "\033[0m'\n");
+    output.append("Result title:   '\033[1;32m" + game.title + "\033[0m' (" + game.titleSrc + ")\n");
+  } else {
+    output.append("Title:          '\033[1;32m" + game.title + "\033[0m' (" + game.titleSrc + ")\n");
+  }
+  if(!config.nameTemplate.isEmpty()) {
+    game.title = StrTools::xmlUnescape(NameTools::getNameFromTemplate(game,
+								      config.nameTemplate));
+  } else {
+    game.title = StrTools::xmlUnescape(game.title);
+    if(config.forceFilename) {
+      game.title = StrTools::xmlUnescape(StrTools::stripBrackets(info.completeBaseName()));
+    }
+    if(config.brackets) {
+      game.title.append(StrTools::xmlUnescape((game.parNotes != ""?" " + game.parNotes:"") + (game.sqrNotes != ""?" " + game.sqrNotes:"")));
+    }
+  }
+  output.append("Platform:       '\033[1;32m" + game.platform + "\033[0m' (" + game.platformSrc + ")\n");
+  output.append("Release Date:   '\033[1;32m");
+  if(game.releaseDate.isEmpty()) {
+    output.append("\033[0m' ()\n");
+  } else {
+    output.append(QDate::fromString(game.releaseDate, "yyyyMMdd").toString("yyyy-MM-dd") + "\033[0m' (" + game.releaseDateSrc + ")\n");
+  }
+  output.append("Developer:      '\033[1;32m" + game.developer + "\033[0m' (" + game.developerSrc + ")\n");
+  output.append("Publisher:      '\033[1;32m" + game.publisher + "\033[0m' (" + game.publisherSrc + ")\n");
+  output.append("Players:        '\033[1;32m" + game.players + "\033[0m' (" + game.playersSrc + ")\n");
+  output.append("Ages:           '\033[1;32m" + game.ages + (game.ages.toInt() != 0?"+":"") + "\033[0m' (" + game.agesSrc + ")\n");
+  output.append("Tags:           '\033[1;32m" + game.tags + "\033[0m' (" + game.tagsSrc + ")\n");
+  output.append("Rating (0-1):   '\033[1;32m" + game.rating + "\033[0m' (" + game.ratingSrc + ")\n");
+  output.append("Cover:          " + QString((game.coverData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheCovers || config.scraper == "cache"?"":" (uncached)")) + " (" + game.coverSrc + ")\n");
+  output.append("Screenshot:     " + QString((game.screenshotData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheScreenshots || config.scraper == "cache"?"":" (uncached)")) + " (" + game.screenshotSrc + ")\n");
+  output.append("Wheel:          " + QString((game.wheelData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheWheels || config.scraper == "cache"?"":" (uncached)")) + " (" + game.wheelSrc + ")\n");
+  output.append("Marquee:        " + QString((game.marqueeData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheMarquees || config.scraper == "cache"?"":" (uncached)")) + " (" + game.marqueeSrc + ")\n");
+  if(config.videos) {
+    output.append("Video:          " + QString((game.videoFormat.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((game.videoData.size() <= config.videoSizeLimit && game.videoSize <= config.videoSizeLimit?"":" (size exceeded, uncached)")) + " (" + game.videoSrc + ")\n");
+  }
+  output.append("\nDescription: (" + game.descriptionSrc + ")\n'\033[1;32m" + game.description.left(config.maxLength) + "\033[0m'\n");
+  if(!cacheOutput.isEmpty()) {
+    output.append("\n\033[1;33mCache output:\033[0m\n" + cacheOutput + "\n");
+  }
+  output.append(job.limitOutput);
+  game.calculateCompleteness();
+  game.resetMedia();
+}
+}
@@ -0,0 +1,96 @@
+/***************************************************************************
+ *            pipeline.h
+ *
+ *  Sat Oct 17 23:13:51 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <QObject>
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+#include "settings.h"
+#include "cache.h"
+#include "queue.h"
+#include "compositor.h"
+#include "stagequeue.h"
+#include "scraperworker.h"
+
+// Runs a scraping run as three stages connected by bounded queues:
+// 1. Hashing: Calculates the cache ids of the files. Uses all cores
+// 2. Scraping: Searches for the files and fetches their data. These are the
+//    ScraperWorker threads, so '--threads' and the module limits only apply here
+// 3. Processing: Composites artwork, adds resources to the cache and reports the
+//    entries. Uses all cores
+// so hashing and compositing no longer holds up the network bound threads.
+class Pipeline : public QObject
+{
+  Q_OBJECT
+
+public:
+  Pipeline(QSharedPointer<Queue> queue, QSharedPointer<Cache> cache, const Settings &config);
+  ~Pipeline();
+  // Calculates all missing cache ids and checksums before the stages are
+  // started. Blocks until done
+  void prehash();
+  void start(const int &totalFiles);
+  int getScraperThreads();
+  int getHashThreads();
+  int getProcessThreads();
+
+signals:
+  void entryReady(const GameEntry &entry, const QString &output, const QString &debug);
+  void allDone();
+
+private slots:
+  void scraperDone();
+
+private:
+  QSharedPointer<Queue> queue;
+  QSharedPointer<Cache> cache;
+  Settings config;
+
+  int scraperThreads;
+  int hashThreads;
+  int processThreads;
+
+  StageQueue hashedJobs;
+  StageQueue scrapedJobs;
+
+  QThreadPool hashPool;
+  QThreadPool processPool;
+  QList<QThread *> threadList;
+
+  QAtomicInt hashersLeft;
+  QAtomicInt scrapersLeft;
+  QAtomicInt processorsLeft;
+
+  void hashFiles();
+  void processEntries();
+  void processEntry(ScrapeJob &job, Compositor &compositor, Settings &config);
+};
+
+#endif // PIPELINE_H
@@ -26,42 +26,83 @@
 #include "queue.h"
 
 #include <QRegularExpression>
+#include <QtConcurrent>
 
 Queue::Queue()
 {
 }
 
-bool Queue::hasEntry()
+bool Queue::takeEntry(QFileInfo &info)
 {
-  queueMutex.lock();
-  if(isEmpty()) {
-    queueMutex.unlock();
+  int index = cursor.fetchAndAddOrdered(1);
+  if(index >= entries.length()) {
+    // Don't let it grow towards overflow if threads keep polling an empty queue
+    cursor.storeRelease(entries.length());
     return false;
   }
+  info = entries.at(index);
   return true;
 }
 
-QFileInfo Queue::takeEntry()
+void Queue::clearAll()
 {
-  QFileInfo info = first();
-  removeFirst();
-  queueMutex.unlock();
-  return info;
+  // Entries are left in place since other threads might be reading them
+  cursor.storeRelease(entries.length());
 }
 
-void Queue::clearAll()
+int Queue::length() const
+{
+  return qMax(entries.length() - cursor.loadAcquire(), 0);
+}
+
+void Queue::append(const QFileInfo &info)
+{
+  compact();
+  entries.append(info);
+}
+
+void Queue::append(const QList<QFileInfo> &infos)
 {
-  queueMutex.lock();
-  clear();
-  queueMutex.unlock();
+  compact();
+  entries.reserve(entries.length() + infos.length());
+  for(const auto &info: infos) {
+    entries.append(info);
+  }
+}
+
+const QFileInfo &Queue::at(const int &index) const
+{
+  return entries.at(cursor.loadAcquire() + index);
+}
+
+void Queue::removeAt(const int &index)
+{
+  compact();
+  entries.removeAt(index);
+}
+
+void Queue::clear()
+{
+  entries.clear();
+  cursor.storeRelease(0);
+}
+
+// Drops entries that have already been taken so indexes start from 0 again
+void Queue::compact()
+{
+  int taken = qMin(cursor.loadAcquire(), entries.length());
+  if(taken > 0) {
+    entries.remove(0, taken);
+  }
+  cursor.storeRelease(0);
 }
 
 void Queue::filterFiles(const QString &patterns, const bool &include)
 {
   QList<QString> regExpPatterns = getRegExpPatterns(patterns);
 
-  queueMutex.lock();
-  QMutableListIterator<QFileInfo> it(*this);
+  compact();
+  QMutableVectorIterator<QFileInfo> it(entries);
   while(it.hasNext()) {
     QFileInfo info = it.next();
     bool match = false;
@@ -76,13 +117,12 @@ void Queue::filterFiles(const QString &patterns, const bool &include)
       it.remove();
     }
   }
-  queueMutex.unlock();
 }
 
 void Queue::removeFiles(const QList<QString> &files)
 {
-  queueMutex.lock();
-  QMutableListIterator<QFileInfo> it(*this);
+  compact();
+  QMutableVectorIterator<QFileInfo> it(entries);
   while(it.hasNext()) {
     QFileInfo info = it.next();
     for(const auto &file: files) {
@@ -92,7 +132,23 @@ void Queue::removeFiles(const QList<QString> &files)
       }
     }
   }
-  queueMutex.unlock();
+}
+
+void Queue::prioritize(const std::function<bool(const QFileInfo &)> &isPriority)
+{
+  compact();
+  // Checking the entries usually means looking at the files, so it is spread over all cores
+  QVector<bool> priority = QtConcurrent::blockingMapped<QVector<bool> >(entries, isPriority);
+  QVector<QFileInfo> prioritized;
+  QVector<QFileInfo> rest;
+  for(int a = 0; a < entries.length(); ++a) {
+    if(priority.at(a)) {
+      prioritized.append(entries.at(a));
+    } else {
+      rest.append(entries.at(a));
+    }
+  }
+  entries = prioritized + rest;
 }
 
 QList<QString> Queue::getRegExpPatterns(QString patterns)
@@ -26,23 +26,44 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
+#include <functional>
+
 #include <QList>
+#include <QVector>
 #include <QFileInfo>
-#include <QMutex>
+#include <QAtomicInt>
 
-class Queue : public QList<QFileInfo>
+// The files of a run. It is filled and filtered from a single thread before the
+// run starts. After that any number of threads can take entries concurrently
+// with 'takeEntry', which just claims the next position with an atomic
+// increment. There is no lock to hold, and every thread pulls from the same
+// cursor, so faster threads naturally take more of the work.
+class Queue
 {
 public:
   Queue();
-  bool hasEntry();
-  QFileInfo takeEntry();
+  // Safe to call concurrently, also from a signal handler
+  bool takeEntry(QFileInfo &info);
   void clearAll();
+  int length() const;
+
+  // Not thread safe, only use these before the run starts
+  void append(const QFileInfo &info);
+  void append(const QList<QFileInfo> &infos);
+  const QFileInfo &at(const int &index) const;
+  void removeAt(const int &index);
+  void clear();
   void filterFiles(const QString &patterns, const bool &include = false);
   void removeFiles(const QList<QString> &files);
+  // Moves matching entries to the front, keeping the order within each group.
+  // 'isPriority' is called from several threads at once
+  void prioritize(const std::function<bool(const QFileInfo &)> &isPriority);
 
 private:
-  QMutex queueMutex;
+  QVector<QFileInfo> entries;
+  QAtomicInt cursor;
   QList<QString> getRegExpPatterns(QString patterns);
+  void compact();
 
 };
 
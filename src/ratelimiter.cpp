@@ -0,0 +1,110 @@
+/***************************************************************************
+ *            ratelimiter.cpp
+ *
+ *  Sat Oct 17 23:05:20 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QEventLoop>
+#include <QTimer>
+
+#include "ratelimiter.h"
+
+constexpr int SLOTPOLL = 50;
+
+QMutex RateLimiter::limitersMutex;
+QMap<QString, QSharedPointer<RateLimiter> > RateLimiter::limiters;
+
+RateLimiter::RateLimiter(const int &interval, const int &concurrency)
+  : interval(interval), concurrency(concurrency)
+{
+  clock.start();
+}
+
+RateLimiter *RateLimiter::get(const QString &module, const int &interval,
+			      const int &concurrency)
+{
+  QMutexLocker locker(&limitersMutex);
+  if(!limiters.contains(module)) {
+    limiters[module] = QSharedPointer<RateLimiter>(new RateLimiter(interval, concurrency));
+  }
+  return limiters[module].data();
+}
+
+qint64 RateLimiter::acquire()
+{
+  qint64 waited = 0;
+  forever {
+    mutex.lock();
+    if(concurrency <= 0 || inFlight < concurrency) {
+      inFlight++;
+      // Reserve the next free slot. Threads arriving while we wait get the ones after it
+      qint64 now = clock.elapsed();
+      qint64 slot = qMax(nextSlot, now);
+      nextSlot = slot + interval;
+      waited += slot - now;
+      totalWait += waited;
+      mutex.unlock();
+      wait(slot - now);
+      return waited;
+    }
+    mutex.unlock();
+    // Our own replies might be the ones holding the slots, so keep processing events
+    wait(SLOTPOLL);
+    waited += SLOTPOLL;
+  }
+}
+
+void RateLimiter::release()
+{
+  QMutexLocker locker(&mutex);
+  if(inFlight > 0) {
+    inFlight--;
+  }
+}
+
+qint64 RateLimiter::getWaitTime()
+{
+  QMutexLocker locker(&mutex);
+  return qMax(nextSlot - clock.elapsed(), (qint64)0);
+}
+
+qint64 RateLimiter::getTotalWait()
+{
+  QMutexLocker locker(&mutex);
+  return totalWait;
+}
+
+int RateLimiter::getInFlight()
+{
+  QMutexLocker locker(&mutex);
+  return inFlight;
+}
+
+void RateLimiter::wait(const qint64 &msecs)
+{
+  if(msecs <= 0) {
+    return;
+  }
+  QEventLoop waitLoop;
+  QTimer::singleShot(msecs, &waitLoop, &QEventLoop::quit);
+  waitLoop.exec();
+}
@@ -0,0 +1,67 @@
+/***************************************************************************
+ *            ratelimiter.h
+ *
+ *  Sat Oct 17 23:05:20 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+
+// Process wide request limiter for a scraping module. All threads scraping with
+// the same module share one instance. Requests are spaced at least 'interval'
+// ms apart across all threads, and at most 'concurrency' of them may be in
+// flight at any time (0 means no cap). Each 'acquire' reserves the next free
+// slot, so the allowed rate is used exactly instead of per thread.
+class RateLimiter
+{
+public:
+  RateLimiter(const int &interval, const int &concurrency);
+  static RateLimiter *get(const QString &module, const int &interval, const int &concurrency);
+  // Waits until a request may be sent while still processing events for the
+  // calling thread. Returns the number of ms waited
+  qint64 acquire();
+  void release();
+  qint64 getWaitTime();
+  qint64 getTotalWait();
+  int getInFlight();
+
+private:
+  QMutex mutex;
+  QElapsedTimer clock;
+  qint64 interval;
+  int concurrency;
+  qint64 nextSlot = 0;
+  int inFlight = 0;
+  qint64 totalWait = 0;
+
+  static void wait(const qint64 &msecs);
+
+  static QMutex limitersMutex;
+  static QMap<QString, QSharedPointer<RateLimiter> > limiters;
+};
+
+#endif // RATELIMITER_H
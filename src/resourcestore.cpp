@@ -0,0 +1,187 @@
+/***************************************************************************
+ *            resourcestore.cpp
+ *
+ *  Sat Oct 17 22:47:05 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <algorithm>
+
+#include "resourcestore.h"
+
+ResourceStore::ResourceStore()
+{
+}
+
+int ResourceStore::length() const
+{
+  return entries.size() - removed;
+}
+
+bool ResourceStore::isEmpty() const
+{
+  return length() == 0;
+}
+
+void ResourceStore::clear()
+{
+  entries.clear();
+  removedEntries.clear();
+  index.clear();
+  removed = 0;
+}
+
+void ResourceStore::append(const Resource &resource)
+{
+  remove(resource.cacheId, resource.type, resource.source);
+  index[resource.cacheId][typeKey(resource.type, resource.source)] = entries.size();
+  entries.append(resource);
+  removedEntries.append(false);
+}
+
+bool ResourceStore::remove(const QString &cacheId, const QString &type, const QString &source)
+{
+  QHash<QString, QHash<QString, int> >::iterator it = index.find(cacheId);
+  if(it == index.end()) {
+    return false;
+  }
+  QHash<QString, int>::iterator posIt = it.value().find(typeKey(type, source));
+  if(posIt == it.value().end()) {
+    return false;
+  }
+  int pos = posIt.value();
+  it.value().erase(posIt);
+  if(it.value().isEmpty()) {
+    index.erase(it);
+  }
+  entries[pos] = Resource();
+  removedEntries[pos] = true;
+  removed++;
+
+  // Only compact once a good chunk of the entries are dead to keep it amortized
+  if(removed > 1024 && removed > entries.size() / 2) {
+    compact();
+  }
+  return true;
+}
+
+bool ResourceStore::contains(const QString &cacheId, const QString &source) const
+{
+  QHash<QString, QHash<QString, int> >::const_iterator it = index.constFind(cacheId);
+  if(it == index.constEnd()) {
+    return false;
+  }
+  if(source.isEmpty()) {
+    return true;
+  }
+  for(const auto &pos: it.value()) {
+    if(entries.at(pos).source == source) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ResourceStore::contains(const QString &cacheId, const QString &type, const QString &source) const
+{
+  QHash<QString, QHash<QString, int> >::const_iterator it = index.constFind(cacheId);
+  if(it == index.constEnd()) {
+    return false;
+  }
+  return it.value().contains(typeKey(type, source));
+}
+
+bool ResourceStore::containsType(const QString &cacheId, const QString &type) const
+{
+  QHash<QString, QHash<QString, int> >::const_iterator it = index.constFind(cacheId);
+  if(it == index.constEnd()) {
+    return false;
+  }
+  for(const auto &pos: it.value()) {
+    if(entries.at(pos).type == type) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Resource ResourceStore::value(const QString &cacheId, const QString &type, const QString &source) const
+{
+  QHash<QString, QHash<QString, int> >::const_iterator it = index.constFind(cacheId);
+  if(it != index.constEnd()) {
+    QHash<QString, int>::const_iterator posIt = it.value().constFind(typeKey(type, source));
+    if(posIt != it.value().constEnd()) {
+      return entries.at(posIt.value());
+    }
+  }
+  return Resource();
+}
+
+QList<Resource> ResourceStore::values(const QString &cacheId, const QString &source) const
+{
+  QList<Resource> matchingResources;
+  QHash<QString, QHash<QString, int> >::const_iterator it = index.constFind(cacheId);
+  if(it == index.constEnd()) {
+    return matchingResources;
+  }
+  // Return them in insertion order since 'Cache::fillType' depends on it
+  QList<int> positions = it.value().values();
+  std::sort(positions.begin(), positions.end());
+  for(const auto &pos: positions) {
+    if(source.isEmpty() || entries.at(pos).source == source) {
+      matchingResources.append(entries.at(pos));
+    }
+  }
+  return matchingResources;
+}
+
+QList<Resource> ResourceStore::toList() const
+{
+  QList<Resource> resources;
+  resources.reserve(length());
+  for(int a = 0; a < entries.size(); ++a) {
+    if(!removedEntries.at(a)) {
+      resources.append(entries.at(a));
+    }
+  }
+  return resources;
+}
+
+QString ResourceStore::typeKey(const QString &type, const QString &source) const
+{
+  return type + "/" + source;
+}
+
+void ResourceStore::compact()
+{
+  QVector<Resource> compacted;
+  compacted.reserve(length());
+  for(int a = 0; a < entries.size(); ++a) {
+    if(!removedEntries.at(a)) {
+      const Resource &res = entries.at(a);
+      index[res.cacheId][typeKey(res.type, res.source)] = compacted.size();
+      compacted.append(res);
+    }
+  }
+  entries = compacted;
+  removedEntries = QVector<bool>(entries.size(), false);
+  removed = 0;
+}
@@ -0,0 +1,89 @@
+/***************************************************************************
+ *            resourcestore.h
+ *
+ *  Sat Oct 17 22:47:05 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef RESOURCESTORE_H
+#define RESOURCESTORE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <QHash>
+
+struct Resource {
+  QString cacheId = "";
+  int version = 1;
+  QString type = "";
+  QString source = "";
+  QString value = "";
+  qint64 timestamp = 0;
+};
+
+// What the cache knows about a rom file. 'timestamp', 'size' and 'inode' tell
+// whether the file is still the one the id and digests were calculated for.
+// 'digests' is a combination of FileHasher::Digest flags, 0 if none are known
+struct QuickId {
+  qint64 timestamp = 0;
+  QString cacheId = "";
+  qint64 size = -1;
+  quint64 inode = 0;
+  int digests = 0;
+  QByteArray md5;
+  QByteArray sha1;
+  quint32 crc32 = 0;
+};
+
+// Keeps resources in insertion order while indexing them by cache id and by
+// type + source within each cache id, so lookups don't scan the entire cache.
+// Appending a resource that already exists replaces it and moves it to the
+// end, just like the remove + append the cache has always done.
+class ResourceStore
+{
+public:
+  ResourceStore();
+  int length() const;
+  bool isEmpty() const;
+  void clear();
+  void append(const Resource &resource);
+  bool remove(const QString &cacheId, const QString &type, const QString &source);
+  bool contains(const QString &cacheId, const QString &source = QString()) const;
+  bool contains(const QString &cacheId, const QString &type, const QString &source) const;
+  bool containsType(const QString &cacheId, const QString &type) const;
+  Resource value(const QString &cacheId, const QString &type, const QString &source) const;
+  QList<Resource> values(const QString &cacheId, const QString &source = QString()) const;
+  QList<Resource> toList() const;
+
+private:
+  QVector<Resource> entries;
+  QVector<bool> removedEntries;
+  // cacheId -> type + source -> position in 'entries'
+  QHash<QString, QHash<QString, int> > index;
+  int removed = 0;
+
+  QString typeKey(const QString &type, const QString &source) const;
+  void compact();
+};
+
+#endif // RESOURCESTORE_H
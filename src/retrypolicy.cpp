@@ -0,0 +1,188 @@
+/***************************************************************************
+ *            retrypolicy.cpp
+ *
+ *  Sat Oct 17 23:11:10 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QEventLoop>
+#include <QMetaEnum>
+#include <QTimer>
+
+#if QT_VERSION >= 0x050a00
+#include <QRandomGenerator>
+#endif
+
+#include "retrypolicy.h"
+
+constexpr int PROBEPOLL = 200;
+
+QMutex RetryPolicy::policiesMutex;
+QMap<QString, QSharedPointer<RetryPolicy> > RetryPolicy::policies;
+
+RetryPolicy::RetryPolicy(const QString &module, const int &baseDelay, const int &maxDelay,
+			 const int &breakerThreshold, const int &breakerPause)
+  : module(module), baseDelay(baseDelay), maxDelay(maxDelay),
+    breakerThreshold(breakerThreshold), breakerPause(breakerPause)
+{
+  clock.start();
+}
+
+RetryPolicy *RetryPolicy::get(const QString &module, const int &baseDelay, const int &maxDelay,
+			      const int &breakerThreshold, const int &breakerPause)
+{
+  QMutexLocker locker(&policiesMutex);
+  if(!policies.contains(module)) {
+    policies[module] = QSharedPointer<RetryPolicy>(new RetryPolicy(module, baseDelay, maxDelay,
+								   breakerThreshold, breakerPause));
+  }
+  return policies[module].data();
+}
+
+void RetryPolicy::printStats()
+{
+  QMutexLocker locker(&policiesMutex);
+  for(const auto &policy: policies) {
+    QMutexLocker policyLocker(&policy->mutex);
+    if(policy->errorCounts.isEmpty()) {
+      continue;
+    }
+    printf("'%s' request failures:\n", policy->module.toStdString().c_str());
+    for(auto it = policy->errorCounts.constBegin(); it != policy->errorCounts.constEnd(); ++it) {
+      printf("  %s: \033[1;33m%d\033[0m\n", it.key().toStdString().c_str(), it.value());
+    }
+    if(policy->pauses > 0) {
+      printf("  Paused due to overload: \033[1;33m%d\033[0m times\n", policy->pauses);
+    }
+    printf("\n");
+  }
+}
+
+void RetryPolicy::waitForCircuit()
+{
+  forever {
+    mutex.lock();
+    if(!open) {
+      mutex.unlock();
+      return;
+    }
+    qint64 remaining = openUntil - clock.elapsed();
+    if(remaining <= 0 && !probing) {
+      // This thread sends the probe, everyone else keeps waiting for its outcome
+      probing = true;
+      mutex.unlock();
+      return;
+    }
+    mutex.unlock();
+    wait(remaining > 0?remaining:PROBEPOLL);
+  }
+}
+
+void RetryPolicy::backoff(const int &attempt)
+{
+  if(attempt < 1) {
+    return;
+  }
+  qint64 delay = qMin((qint64)baseDelay << qMin(attempt - 1, 16), (qint64)maxDelay);
+  // Wait at least half of it, the rest is random so threads spread out
+  qint64 half = delay / 2;
+#if QT_VERSION >= 0x050a00
+  qint64 jitter = QRandomGenerator::global()->bounded((int)half + 1);
+#else
+  qint64 jitter = qrand() % (half + 1);
+#endif
+  wait(half + jitter);
+}
+
+void RetryPolicy::record(const QNetworkReply::NetworkError &error)
+{
+  if(error == QNetworkReply::NoError) {
+    succeeded();
+    return;
+  }
+  const char *name = QMetaEnum::fromType<QNetworkReply::NetworkError>().valueToKey(error);
+  failed(name != nullptr?QString(name):QString::number(error), isTransient(error));
+}
+
+void RetryPolicy::succeeded()
+{
+  QMutexLocker locker(&mutex);
+  consecutiveFailures = 0;
+  if(open) {
+    printf("\033[1;32m'%s' is responding again, resuming...\033[0m\n", module.toStdString().c_str());
+  }
+  open = false;
+  probing = false;
+}
+
+void RetryPolicy::failed(const QString &errorClass, const bool &transient)
+{
+  QMutexLocker locker(&mutex);
+  errorCounts[errorClass]++;
+  if(!transient) {
+    if(probing) {
+      // The server answered the probe, so it's not overloaded anymore
+      consecutiveFailures = 0;
+      open = false;
+      probing = false;
+    }
+    return;
+  }
+  consecutiveFailures++;
+  if(probing || (!open && consecutiveFailures >= breakerThreshold)) {
+    if(!probing) {
+      printf("\033[1;33m'%s' seems to be overloaded, pausing all requests for %d seconds...\033[0m\n",
+	     module.toStdString().c_str(), breakerPause / 1000);
+      pauses++;
+    }
+    open = true;
+    probing = false;
+    openUntil = clock.elapsed() + breakerPause;
+  }
+}
+
+bool RetryPolicy::isTransient(const QNetworkReply::NetworkError &error)
+{
+  switch(error) {
+  case QNetworkReply::RemoteHostClosedError:
+  case QNetworkReply::ConnectionRefusedError:
+  case QNetworkReply::TimeoutError:
+  case QNetworkReply::TemporaryNetworkFailureError:
+  case QNetworkReply::NetworkSessionFailedError:
+  case QNetworkReply::InternalServerError:
+  case QNetworkReply::ServiceUnavailableError:
+  case QNetworkReply::UnknownServerError:
+  case QNetworkReply::UnknownNetworkError:
+    return true;
+  default:
+    return false;
+  }
+}
+
+void RetryPolicy::wait(const qint64 &msecs)
+{
+  if(msecs <= 0) {
+    return;
+  }
+  QEventLoop waitLoop;
+  QTimer::singleShot(msecs, &waitLoop, &QEventLoop::quit);
+  waitLoop.exec();
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+ *            retrypolicy.h
+ *
+ *  Sat Oct 17 23:11:10 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include <QNetworkReply>
+
+// Process wide retry policy for a scraping module, shared by all threads using
+// it. Retries back off exponentially with jitter so threads don't retry in
+// lockstep. Once 'breakerThreshold' transient failures (the server closing the
+// connection, timeouts, server errors) happen in a row across all threads,
+// the module pauses for 'breakerPause' ms. After that a single request is let
+// through to probe the server, and everyone resumes if it succeeds.
+class RetryPolicy
+{
+public:
+  RetryPolicy(const QString &module, const int &baseDelay, const int &maxDelay,
+	      const int &breakerThreshold, const int &breakerPause);
+  static RetryPolicy *get(const QString &module, const int &baseDelay, const int &maxDelay,
+			  const int &breakerThreshold, const int &breakerPause);
+  static void printStats();
+  // Blocks while the module is paused
+  void waitForCircuit();
+  // Waits before retry number 'attempt' (1 for the first retry)
+  void backoff(const int &attempt);
+  void record(const QNetworkReply::NetworkError &error);
+  void succeeded();
+  void failed(const QString &errorClass, const bool &transient);
+
+private:
+  QMutex mutex;
+  QElapsedTimer clock;
+  QString module;
+  int baseDelay;
+  int maxDelay;
+  int breakerThreshold;
+  int breakerPause;
+  int consecutiveFailures = 0;
+  bool open = false;
+  bool probing = false;
+  qint64 openUntil = 0;
+  int pauses = 0;
+  QMap<QString, int> errorCounts;
+
+  static bool isTransient(const QNetworkReply::NetworkError &error);
+  static void wait(const qint64 &msecs);
+
+  static QMutex policiesMutex;
+  static QMap<QString, QSharedPointer<RetryPolicy> > policies;
+};
+
+#endif // RETRYPOLICY_H
@@ -25,13 +25,11 @@
 
 #include <iostream>
 #include <QTimer>
-#include <QRegularExpression>
 
 #include "scraperworker.h"
 #include "strtools.h"
 #include "nametools.h"
 #include "settings.h"
-#include "compositor.h"
 
 #include "openretro.h"
 #include "thegamesdb.h"
@@ -44,12 +42,13 @@
 #include "arcadedb.h"
 #include "esgamelist.h"
 
-ScraperWorker::ScraperWorker(QSharedPointer<Queue> queue,
+ScraperWorker::ScraperWorker(StageQueue *hashedJobs,
+			     StageQueue *scrapedJobs,
 			     QSharedPointer<Cache> cache,
-			     QSharedPointer<NetManager> manager,
 			     Settings config,
 			     QString threadId)
-  : config(config), cache(cache), manager(manager), queue(queue), threadId(threadId)
+  : config(config), cache(cache), hashedJobs(hashedJobs), scrapedJobs(scrapedJobs),
+    threadId(threadId)
 {
 }
 
@@ -59,6 +58,8 @@ ScraperWorker::~ScraperWorker()
 
 void ScraperWorker::run()
 {
+  // Created here so it belongs to this thread and keeps its own connection pool
+  manager = QSharedPointer<NetManager>(new NetManager());
   if(config.scraper == "openretro") {
     scraper = new OpenRetro(&config, manager);
   } else if(config.scraper == "thegamesdb") {
@@ -88,25 +89,20 @@ void ScraperWorker::run()
   }
   platformOrig = config.platform;
 
-  Compositor compositor(&config);
-  if(!compositor.processXml()) {
-    printf("Something went wrong when parsing artwork xml from '%s', please check the file for errors. Now exiting...\n", config.artworkConfig.toStdString().c_str());
-    exit(1);
-  }
-
-  while(queue->hasEntry()) {
-    // takeEntry() also unlocks the mutex that was locked in hasEntry()
-    QFileInfo info = queue->takeEntry();
+  while(true) {
+    ScrapeJob job;
+    if(!hashedJobs->pop(job)) {
+      break;
+    }
+    const QFileInfo &info = job.info;
+    const QString &cacheId = job.cacheId;
     // Reset platform in case we have manipulated it (such as changing 'amiga' to 'cd32')
     config.platform = platformOrig;
-    QString output = "\033[1;33m(T" + threadId + ")\033[0m ";
-    QString debug = "";
-    QString cacheId = cache->getQuickId(info);
-    if(cacheId.isEmpty()) {
-      cacheId = NameTools::getCacheId(info);
-      cache->addQuickId(info, cacheId);
-    }
-    QString compareTitle = scraper->getCompareTitle(info);
+    QString &output = job.output;
+    QString &debug = job.debug;
+    output = "\033[1;33m(T" + threadId + ")\033[0m ";
+    job.compareTitle = scraper->getCompareTitle(info);
+    const QString &compareTitle = job.compareTitle;
 
     // For Amiga platform, change to subplatforms if detected as such
     if(config.platform == "amiga") {
@@ -121,12 +117,12 @@ void ScraperWorker::run()
     }
 
     // Create the game entry we use for the rest of the process
-    GameEntry game;
+    GameEntry &game = job.game;
 
     // Create list for potential game entries that will come from the scraping source
     QList<GameEntry> gameEntries;
 
-    bool fromCache = false;
+    bool &fromCache = job.fromCache;
     if(config.scraper == "cache" && cache->hasEntries(cacheId)) {
       fromCache = true;
       GameEntry cachedGame;
@@ -145,7 +141,8 @@ void ScraperWorker::run()
       game.title = compareTitle;
       output.append("\033[1;33m---- Skipping game '" + info.completeBaseName() + "' since 'onlymissing' flag has been set ----\033[0m\n\n");
       game.resetMedia();
-      emit entryReady(game, output, debug);
+      job.done = true;
+      scrapedJobs->push(job);
       if(forceEnd) {
 	break;
       } else {
@@ -206,7 +203,8 @@ void ScraperWorker::run()
       game.resetMedia();
       if(!forceEnd)
 	forceEnd = limitReached(output);
-      emit entryReady(game, output, debug);
+      job.done = true;
+      scrapedJobs->push(job);
       if(forceEnd) {
 	break;
       } else {
@@ -214,15 +212,16 @@ void ScraperWorker::run()
       }
     }
 
-    int searchMatch = getSearchMatch(game.title, compareTitle, lowestDistance);
-    game.searchMatch = searchMatch;
-    if(searchMatch < config.minMatch) {
+    job.searchMatch = getSearchMatch(game.title, compareTitle, lowestDistance);
+    game.searchMatch = job.searchMatch;
+    if(job.searchMatch < config.minMatch) {
       output.append("\033[1;33m---- Game '" + info.completeBaseName() + "' match too low :| ----\033[0m\n\n");
       game.found = false;
       game.resetMedia();
       if(!forceEnd)
 	forceEnd = limitReached(output);
-      emit entryReady(game, output, debug);
+      job.done = true;
+      scrapedJobs->push(job);
       if(forceEnd) {
 	break;
       } else {
@@ -236,138 +235,24 @@ void ScraperWorker::run()
       scraper->getGameData(game);
     }
 
-    if(!config.pretend && config.scraper == "cache") {
-      // Process all artwork
-      compositor.saveAll(game, info.completeBaseName());
-      // Copy or symlink videos as requested
-      if(config.videos &&
-	 game.videoFormat != "" &&
-	 !game.videoFile.isEmpty() &&
-	 QFile::exists(game.videoFile)) {
-	QString videoDst = config.videosFolder + "/" + info.completeBaseName() + "." + game.videoFormat;
-	if(config.skipExistingVideos && QFile::exists(videoDst)) {
-	} else {
-	  if(QFile::exists(videoDst)) {
-	    QFile::remove(videoDst);
-	  }
-	  if(config.symlink) {
-	    // Try to remove existing video destination file before linking
-	    if(!QFile::link(game.videoFile, videoDst)) {
-	      game.videoFormat = "";
-	    }
-	  } else {
-	    QFile videoFile(videoDst);
-	    if(videoFile.open(QIODevice::WriteOnly)) {
-	      videoFile.write(game.videoData);
-	      videoFile.close();
-	    } else {
-	      game.videoFormat = "";
-	    }
-	  }
-	}
-      }
-    }
-    
-    // Add all resources to the cache
-    QString cacheOutput = "";
-    if(config.scraper != "cache" && game.found && !fromCache) {
-      game.source = config.scraper;
-      cache->addResources(game, config, cacheOutput);
-    }
-
-    // We're done saving the raw data at this point, so feel free to manipulate game resources to better suit game list creation from here on out.
-
-    // Strip any brackets from the title as they will be readded when assembling gamelist
-    game.title = StrTools::stripBrackets(game.title);
-
-    // Move 'The' or ', The' depending on the config. This does not affect game list sorting. 'The ' is always removed before sorting.
-    if(config.theInFront) {
-      QRegularExpression theMatch(", [Tt]{1}he");
-      if(theMatch.match(game.title).hasMatch()) {
-	game.title.replace(theMatch.match(game.title).captured(0), "");
-	game.title.prepend("The ");
-      }
-    } else {
-      if(game.title.toLower().left(4) == "the ") {
-	game.title = game.title.remove(0, 4).simplified().append(", The");
-      }
-    }
-
-    // Don't unescape title since we already did that in getBestEntry()
-    game.videoFile = StrTools::xmlUnescape(config.videosFolder + "/" + info.completeBaseName() + "." + game.videoFormat);
-    game.description = StrTools::xmlUnescape(game.description);
-    game.releaseDate = StrTools::xmlUnescape(game.releaseDate);
-    // Make sure we have the correct 'yyyymmdd' format of 'releaseDate'
-    game.releaseDate = StrTools::conformReleaseDate(game.releaseDate);
-    game.developer = StrTools::xmlUnescape(game.developer);
-    game.publisher = StrTools::xmlUnescape(game.publisher);
-    game.tags = StrTools::xmlUnescape(game.tags);
-    game.tags = StrTools::conformTags(game.tags);
-    game.rating = StrTools::xmlUnescape(game.rating);
-    game.players = StrTools::xmlUnescape(game.players);
-    // Make sure we have the correct single digit format of 'players'
-    game.players = StrTools::conformPlayers(game.players);
-    game.ages = StrTools::xmlUnescape(game.ages);
-    // Make sure we have the correct format of 'ages'
-    game.ages = StrTools::conformAges(game.ages);
-
-    output.append("Scraper:        " + config.scraper + "\n");
-    if(config.scraper != "cache" && config.scraper != "import") {
-      output.append("From cache:     " + QString((fromCache?"YES (refresh from source with '--cache refresh')":"NO")) + "\n");
-      output.append("Search match:   " + QString::number(searchMatch) + " %\n");
-      output.append("Compare title:  '\033[1;32m" + compareTitle + "\033[0m'\n");
-      output.append("Result title:   '\033[1;32m" + game.title + "\033[0m' (" + game.titleSrc + ")\n");
-    } else {
-      output.append("Title:          '\033[1;32m" + game.title + "\033[0m' (" + game.titleSrc + ")\n");
-    }
-    if(!config.nameTemplate.isEmpty()) {
-      game.title = StrTools::xmlUnescape(NameTools::getNameFromTemplate(game,
-									config.nameTemplate));
-    } else {
-      game.title = StrTools::xmlUnescape(game.title);
-      if(config.forceFilename) {
-	game.title = StrTools::xmlUnescape(StrTools::stripBrackets(info.completeBaseName()));
-      }
-      if(config.brackets) {
-	game.title.append(StrTools::xmlUnescape((game.parNotes != ""?" " + game.parNotes:"") + (game.sqrNotes != ""?" " + game.sqrNotes:"")));
-      }
-    }
-    output.append("Platform:       '\033[1;32m" + game.platform + "\033[0m' (" + game.platformSrc + ")\n");
-    output.append("Release Date:   '\033[1;32m");
-    if(game.releaseDate.isEmpty()) {
-      output.append("\033[0m' ()\n");
-    } else {
-      output.append(QDate::fromString(game.releaseDate, "yyyyMMdd").toString("yyyy-MM-dd") + "\033[0m' (" + game.releaseDateSrc + ")\n");
-    }
-    output.append("Developer:      '\033[1;32m" + game.developer + "\033[0m' (" + game.developerSrc + ")\n");
-    output.append("Publisher:      '\033[1;32m" + game.publisher + "\033[0m' (" + game.publisherSrc + ")\n");
-    output.append("Players:        '\033[1;32m" + game.players + "\033[0m' (" + game.playersSrc + ")\n");
-    output.append("Ages:           '\033[1;32m" + game.ages + (game.ages.toInt() != 0?"+":"") + "\033[0m' (" + game.agesSrc + ")\n");
-    output.append("Tags:           '\033[1;32m" + game.tags + "\033[0m' (" + game.tagsSrc + ")\n");
-    output.append("Rating (0-1):   '\033[1;32m" + game.rating + "\033[0m' (" + game.ratingSrc + ")\n");
-    output.append("Cover:          " + QString((game.coverData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheCovers || config.scraper == "cache"?"":" (uncached)")) + " (" + game.coverSrc + ")\n");
-    output.append("Screenshot:     " + QString((game.screenshotData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheScreenshots || config.scraper == "cache"?"":" (uncached)")) + " (" + game.screenshotSrc + ")\n");
-    output.append("Wheel:          " + QString((game.wheelData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheWheels || config.scraper == "cache"?"":" (uncached)")) + " (" + game.wheelSrc + ")\n");
-    output.append("Marquee:        " + QString((game.marqueeData.isNull()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((config.cacheMarquees || config.scraper == "cache"?"":" (uncached)")) + " (" + game.marqueeSrc + ")\n");
-    if(config.videos) {
-      output.append("Video:          " + QString((game.videoFormat.isEmpty()?"\033[1;31mNO":"\033[1;32mYES")) + "\033[0m" + QString((game.videoData.size() <= config.videoSizeLimit?"":" (size exceeded, uncached)")) + " (" + game.videoSrc + ")\n");
+    if(config.verbosity >= 1 && scraper->rateLimiter != nullptr) {
+      job.rateLimit = "Rate limit:     " + QString::number(scraper->rateLimiter->getWaitTime()) + " ms until next request slot, " + QString::number(scraper->rateLimiter->getInFlight()) + " in flight, " + QString::number(scraper->rateLimiter->getTotalWait() / 1000) + " s waited in total\n";
     }
-    output.append("\nDescription: (" + game.descriptionSrc + ")\n'\033[1;32m" + game.description.left(config.maxLength) + "\033[0m'\n");
-    if(!cacheOutput.isEmpty()) {
-      output.append("\n\033[1;33mCache output:\033[0m\n" + cacheOutput + "\n");
+    if(config.verbosity >= 1 && scraper->batcher != nullptr) {
+      job.rateLimit.append("Batching:       " + QString::number(scraper->batcher->getLookups()) + " game lookups sent as " + QString::number(scraper->batcher->getRequests()) + " requests\n");
     }
     if(!forceEnd) {
-      forceEnd = limitReached(output);
+      forceEnd = limitReached(job.limitOutput);
     }
-    game.calculateCompleteness();
-    game.resetMedia();
-    emit entryReady(game, output, debug);
+    // Compositing, caching and reporting is done by the processing stage
+    scrapedJobs->push(job);
     if(forceEnd) {
       break;
     }
   }
 
   delete scraper;
+  manager.clear();
   emit allDone();
 }
 
@@ -29,7 +29,7 @@
 #include "abstractscraper.h"
 #include "settings.h"
 #include "cache.h"
-#include "queue.h"
+#include "stagequeue.h"
 #include "netmanager.h"
 
 #include <QImage>
@@ -41,9 +41,9 @@ class ScraperWorker : public QObject
   Q_OBJECT
 
 public:
-  ScraperWorker(QSharedPointer<Queue> queue,
+  ScraperWorker(StageQueue *hashedJobs,
+		StageQueue *scrapedJobs,
 		QSharedPointer<Cache> cache,
-		QSharedPointer<NetManager> manager,
 		Settings config,
 		QString threadId);
   ~ScraperWorker();
@@ -52,7 +52,6 @@ public:
 
 signals:
   void allDone();
-  void entryReady(const GameEntry &entry, const QString &output, const QString &debug);
 
 private:
   AbstractScraper *scraper;
@@ -61,7 +60,9 @@ private:
 
   QSharedPointer<Cache> cache;
   QSharedPointer<NetManager> manager;
-  QSharedPointer<Queue> queue;
+  // Owned by the pipeline. Files come in hashed and leave searched and fetched
+  StageQueue *hashedJobs;
+  StageQueue *scrapedJobs;
 
   QString platformOrig;
   QString threadId;
@@ -30,6 +30,10 @@
 #include "screenscraper.h"
 #include "strtools.h"
 #include "crc32.h"
+#include "filehasher.h"
+#ifdef WITH_ZLIB
+#include "zipreader.h"
+#endif
 
 constexpr int RETRIESMAX = 4;
 constexpr int MINARTSIZE = 256;
@@ -38,10 +42,21 @@ ScreenScraper::ScreenScraper(Settings *config,
 			     QSharedPointer<NetManager> manager)
   : AbstractScraper(config, manager)
 {
-  connect(&limitTimer, &QTimer::timeout, &limiter, &QEventLoop::quit);
-  limitTimer.setInterval(1200); // 1.2 second request limit set a bit above 1.0 as requested by the good folks at ScreenScraper. Don't change!
-  limitTimer.setSingleShot(false);
-  limitTimer.start();
+  // 1.2 second request limit per allowed thread set a bit above 1.0 as requested by the good folks at ScreenScraper. Don't change!
+  rateLimiter = RateLimiter::get("screenscraper", 1200 / qMax(config->threads, 1),
+				 config->threads);
+  netComm->setRateLimiter(rateLimiter);
+  // Back off from 1 up to 30 seconds between retries. Pause everything for 30 seconds after 8 overload errors in a row
+  retryPolicy = RetryPolicy::get("screenscraper", 1000, 30000, 8, 30000);
+  // ScreenScraper sends its error, quota and busy messages as '200 OK', so
+  // only cache answers that actually contain a game
+  netComm->setCacheValidator([](const QByteArray &body) {
+      QByteArray fixedBody = body;
+      fixedBody.replace("],\n\t\t}", "]\n\t\t}");
+      QJsonObject jsonObj = QJsonDocument::fromJson(fixedBody).object();
+      return (jsonObj["header"].toObject()["success"].toString() == "true" &&
+	      jsonObj["response"].toObject().contains("jeu"));
+    });
 
   baseUrl = "http://www.screenscraper.fr";
 
@@ -73,33 +88,45 @@ void ScreenScraper::getSearchResults(QList<GameEntry> &gameEntries,
   QString gameUrl = "https://www.screenscraper.fr/api2/jeuInfos.php?devid=muldjord&devpassword=" + StrTools::unMagic("204;198;236;130;203;181;203;126;191;167;200;198;192;228;169;156") + "&softname=skyscraper" VERSION + (config->user.isEmpty()?"":"&ssid=" + config->user) + (config->password.isEmpty()?"":"&sspassword=" + config->password) + (platformId.isEmpty()?"":"&systemeid=" + platformId) + "&output=json&" + searchName;
 
   for(int retries = 0; retries < RETRIESMAX; ++retries) {
-    limiter.exec();
+    retryPolicy->waitForCircuit();
+    retryPolicy->backoff(retries);
     netComm->request(gameUrl);
     q.exec();
     data = netComm->getData();
     
     QByteArray headerData = data.left(1024); // Minor optimization with minimal more RAM usage
-    // Do error checks on headerData. It's more stable than checking the potentially faulty JSON
+    // Do error checks on headerData. It's more stable than checking the potentially faulty JSON.
+    // Each answer is recorded with the retry policy exactly once, as what it turned out to be
     if(headerData.isEmpty()) {
+      if(netComm->getError() != QNetworkReply::NoError) {
+	retryPolicy->record(netComm->getError());
+      } else {
+	retryPolicy->failed("EmptyResponse", true);
+      }
       printf("\033[1;33mRetrying request...\033[0m\n\n");
       continue;
     } else if(headerData.contains("non trouvée")) {
+      retryPolicy->succeeded();
       return;
     } else if(headerData.contains("API totalement fermé")) {
+      retryPolicy->failed("ServiceClosed", false);
       printf("\033[1;31mThe ScreenScraper API is currently closed, exiting nicely...\033[0m\n\n");
       reqRemaining = 0;
       return;
     } else if(headerData.contains("Le logiciel de scrape utilisé a été blacklisté")) {
+      retryPolicy->failed("Blacklisted", false);
       printf("\033[1;31mSkyscraper has apparently been blacklisted at ScreenScraper, exiting nicely...\033[0m\n\n");
       reqRemaining = 0;
       return;
     } else if(headerData.contains("Votre quota de scrape est")) {
+      retryPolicy->failed("QuotaReached", false);
       printf("\033[1;31mYour daily ScreenScraper request limit has been reached, exiting nicely...\033[0m\n\n");
       reqRemaining = 0;
       return;
     } else if(headerData.contains("API fermé pour les non membres") ||
 	      headerData.contains("API closed for non-registered members") ||
 	      headerData.contains("****T****h****e**** ****m****a****x****i****m****u****m**** ****t****h****r****e****a****d****s**** ****a****l****l****o****w****e****d**** ****t****o**** ****l****e****e****c****h****e****r**** ****u****s****e****r****s**** ****i****s**** ****a****l****r****e****a****d****y**** ****u****s****e****d****")) {
+      retryPolicy->failed("ServiceBusy", true);
       printf("\033[1;31mThe screenscraper service is currently closed or too busy to handle requests from unregistered and inactive users. Sign up for an account at https://www.screenscraper.fr and contribute to gain more threads. Then use the credentials with Skyscraper using the '-u user:pass' command line option or by setting 'userCreds=\"user:pass\"' in '/home/USER/.skyscraper/config.ini'.\033[0m\n\n");
       if(retries == RETRIESMAX - 1) {
 	reqRemaining = 0;
@@ -117,6 +144,12 @@ void ScreenScraper::getSearchResults(QList<GameEntry> &gameEntries,
 
     // Check if we got a valid JSON document back
     if(jsonObj.isEmpty()) {
+      if(netComm->getError() != QNetworkReply::NoError) {
+	// Such as an error page from an overloaded server
+	retryPolicy->record(netComm->getError());
+      } else {
+	retryPolicy->failed("InvalidContent", false);
+      }
       printf("\033[1;31mScreenScraper APIv2 returned invalid / empty Json. Their servers are probably down. Please try again later or use a different scraping module with '-s MODULE'. Check 'Skyscraper --help' for more information.\033[0m\n");
       data.replace(StrTools::unMagic("204;198;236;130;203;181;203;126;191;167;200;198;192;228;169;156"), "****");
       data.replace(config->password.toUtf8(), "****");
@@ -130,6 +163,7 @@ void ScreenScraper::getSearchResults(QList<GameEntry> &gameEntries,
       }
       break; // DON'T try again! If we don't get a valid JSON document, something is very wrong with the API
     }
+    retryPolicy->succeeded();
 
     // Check if the request was successful
     if(jsonObj["header"].toObject()["success"].toString() != "true") {
@@ -140,8 +174,10 @@ void ScreenScraper::getSearchResults(QList<GameEntry> &gameEntries,
       continue;
     }
     
-    // Check if user has exceeded daily request limit
-    if(!jsonObj["response"].toObject()["ssuser"].toObject()["requeststoday"].toString().isEmpty() && !jsonObj["response"].toObject()["ssuser"].toObject()["maxrequestsperday"].toString().isEmpty()) {
+    // Check if user has exceeded daily request limit. A cached answer holds the
+    // numbers from when it was stored, so only trust fresh ones
+    if(!netComm->isFromCache() &&
+       !jsonObj["response"].toObject()["ssuser"].toObject()["requeststoday"].toString().isEmpty() && !jsonObj["response"].toObject()["ssuser"].toObject()["maxrequestsperday"].toString().isEmpty()) {
       reqRemaining = jsonObj["response"].toObject()["ssuser"].toObject()["maxrequestsperday"].toString().toInt() - jsonObj["response"].toObject()["ssuser"].toObject()["requeststoday"].toString().toInt();
       if(reqRemaining <= 0) {
 	printf("\033[1;31mYour daily ScreenScraper request limit has been reached, exiting nicely...\033[0m\n\n");
@@ -238,6 +274,7 @@ void ScreenScraper::getGameData(GameEntry &game)
       ;
     }
   }
+  fetchMedia();
 }
 
 void ScreenScraper::getReleaseDate(GameEntry &game)
@@ -329,22 +366,16 @@ void ScreenScraper::getCover(GameEntry &game)
     url = getJsonText(jsonObj["medias"].toArray(), REGION, QList<QString>({"box-2D"}));
   }
   if(!url.isEmpty()) {
-    bool moveOn = true;
-    for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
-      netComm->request(url);
-      q.exec();
-      QImage image;
-      if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
-	 netComm->getData().size() >= MINARTSIZE &&
-	 image.loadFromData(netComm->getData())) {
-	game.coverData = netComm->getData();
-      } else {
-	moveOn = false;
-      }
-      if(moveOn)
-	break;
-    }
+    queueMedia({url}, [this, &game](const NetResult &result) {
+	QImage image;
+	if(result.getError(config->verbosity) == QNetworkReply::NoError &&
+	   result.getData().size() >= MINARTSIZE &&
+	   image.loadFromData(result.getData())) {
+	  game.coverData = result.getData();
+	  return true;
+	}
+	return false;
+      }, RETRIESMAX);
   }
 }
 
@@ -352,22 +383,16 @@ void ScreenScraper::getScreenshot(GameEntry &game)
 {
   QString url = getJsonText(jsonObj["medias"].toArray(), REGION, QList<QString>({"ss", "sstitle"}));
   if(!url.isEmpty()) {
-    bool moveOn = true;
-    for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
-      netComm->request(url);
-      q.exec();
-      QImage image;
-      if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
-	 netComm->getData().size() >= MINARTSIZE &&
-	 image.loadFromData(netComm->getData())) {
-	game.screenshotData = netComm->getData();
-      } else {
-	moveOn = false;
-      }
-      if(moveOn)
-	break;
-    }
+    queueMedia({url}, [this, &game](const NetResult &result) {
+	QImage image;
+	if(result.getError(config->verbosity) == QNetworkReply::NoError &&
+	   result.getData().size() >= MINARTSIZE &&
+	   image.loadFromData(result.getData())) {
+	  game.screenshotData = result.getData();
+	  return true;
+	}
+	return false;
+      }, RETRIESMAX);
   }
 }
 
@@ -375,22 +400,16 @@ void ScreenScraper::getWheel(GameEntry &game)
 {
   QString url = getJsonText(jsonObj["medias"].toArray(), REGION, QList<QString>({"wheel", "wheel-hd"}));
   if(!url.isEmpty()) {
-    bool moveOn = true;
-    for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
-      netComm->request(url);
-      q.exec();
-      QImage image;
-      if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
-	 netComm->getData().size() >= MINARTSIZE &&
-	 image.loadFromData(netComm->getData())) {
-	game.wheelData = netComm->getData();
-      } else {
-	moveOn = false;
-      }
-      if(moveOn)
-	break;
-    }
+    queueMedia({url}, [this, &game](const NetResult &result) {
+	QImage image;
+	if(result.getError(config->verbosity) == QNetworkReply::NoError &&
+	   result.getData().size() >= MINARTSIZE &&
+	   image.loadFromData(result.getData())) {
+	  game.wheelData = result.getData();
+	  return true;
+	}
+	return false;
+      }, RETRIESMAX);
   }
 }
 
@@ -398,22 +417,16 @@ void ScreenScraper::getMarquee(GameEntry &game)
 {
   QString url = getJsonText(jsonObj["medias"].toArray(), REGION, QList<QString>({"screenmarquee"}));
   if(!url.isEmpty()) {
-    bool moveOn = true;
-    for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
-      netComm->request(url);
-      q.exec();
-      QImage image;
-      if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
-	 netComm->getData().size() >= MINARTSIZE &&
-	 image.loadFromData(netComm->getData())) {
-	game.marqueeData = netComm->getData();
-      } else {
-	moveOn = false;
-      }
-      if(moveOn)
-	break;
-    }
+    queueMedia({url}, [this, &game](const NetResult &result) {
+	QImage image;
+	if(result.getError(config->verbosity) == QNetworkReply::NoError &&
+	   result.getData().size() >= MINARTSIZE &&
+	   image.loadFromData(result.getData())) {
+	  game.marqueeData = result.getData();
+	  return true;
+	}
+	return false;
+      }, RETRIESMAX);
   }
 }
 
@@ -426,26 +439,25 @@ void ScreenScraper::getVideo(GameEntry &game)
   types.append("video");
   QString url = getJsonText(jsonObj["medias"].toArray(), NONE, types);
   if(!url.isEmpty()) {
-    bool moveOn = true;
-    for(int retries = 0; retries < RETRIESMAX; ++retries) {
-      limiter.exec();
-      netComm->request(url);
-      q.exec();
-      game.videoData = netComm->getData();
-      // Make sure received data is actually a video file
-      QByteArray contentType = netComm->getContentType();
-      if(netComm->getError(config->verbosity) == QNetworkReply::NoError &&
-	 contentType.contains("video/") &&
-	 game.videoData.size() > 4096) {
-	game.videoFormat = contentType.mid(contentType.indexOf("/") + 1,
-					   contentType.length() - contentType.indexOf("/") + 1);
-      } else {
-	game.videoData = "";
-	moveOn = false;
-      }
-      if(moveOn)
-	break;
-    }
+    queueMediaToFile({url}, [this, &game](const NetResult &result) {
+	if(result.isSizeExceeded()) {
+	  // Retrying won't make it any smaller
+	  game.videoSize = result.getSize();
+	  return true;
+	}
+	// Make sure received data is actually a video file
+	QByteArray contentType = result.getContentType();
+	if(result.getError(config->verbosity) == QNetworkReply::NoError &&
+	   contentType.contains("video/") &&
+	   result.getSize() > 4096) {
+	  game.videoTempFile = result.getFileName();
+	  game.videoSize = result.getSize();
+	  game.videoFormat = contentType.mid(contentType.indexOf("/") + 1,
+					     contentType.length() - contentType.indexOf("/") + 1);
+	  return true;
+	}
+	return false;
+      }, RETRIESMAX);
   }
 }
 
@@ -455,13 +467,46 @@ QList<QString> ScreenScraper::getSearchNames(const QFileInfo &info)
   QCryptographicHash md5(QCryptographicHash::Md5);
   QCryptographicHash sha1(QCryptographicHash::Sha1);
   Crc32 crc;
-  crc.initInstance(1);
+  bool zipRead = false;
+  quint32 zipCrc = 0;
 
   bool unpack = config->unpack;
 
   if(unpack) {
+#ifdef WITH_ZLIB
+    // Zip files are decompressed in-process in chunks while being hashed, so they
+    // need neither the 7z process nor the size limit
+    ZipReader zip;
+    if(info.suffix() == "zip" && zip.open(info.absoluteFilePath())) {
+      zipRead = true;
+      QList<ZipEntry> files;
+      for(const auto &entry: zip.getEntries()) {
+	if(!entry.fileName.endsWith("/")) {
+	  files.append(entry);
+	}
+      }
+      if(files.length() != 1) {
+	printf("Compressed file doesn't contain exactly 1 file, falling back...\n");
+	unpack = false;
+      } else if(ZipReader::isSupported(files.first()) &&
+		zip.read(files.first(), [&md5, &sha1](const char *data, const qint64 &size) {
+		    md5.addData(data, size);
+		    sha1.addData(data, size);
+		  })) {
+	// The central directory already holds the crc of the uncompressed data
+	zipCrc = files.first().crc32;
+      } else {
+	// Encrypted, compressed with a method we can't decompress or damaged. Let 7z have a go
+	md5.reset();
+	sha1.reset();
+	zipRead = false;
+      }
+    }
+#endif
     // Size limit for "unpack" is set to 8 megs to ensure the pi doesn't run out of memory
-    if((info.suffix() == "7z" || info.suffix() == "zip") && info.size() < 81920000) {
+    if(zipRead) {
+      // Already hashed above
+    } else if((info.suffix() == "7z" || info.suffix() == "zip") && info.size() < 81920000) {
       // For 7z (7z, zip) unpacked file reading
       {
 	QProcess decProc;
@@ -491,7 +536,7 @@ QList<QString> ScreenScraper::getSearchNames(const QFileInfo &info)
 	    QByteArray allData = decProc.readAllStandardOutput();
 	    md5.addData(allData);
 	    sha1.addData(allData);
-	    crc.pushData(1, allData.data(), allData.length());
+	    crc.pushData(allData.constData(), allData.length());
 	  } else {
 	    printf("Something went wrong when decompressing file to stdout, falling back...\n");
 	    unpack = false;
@@ -507,29 +552,28 @@ QList<QString> ScreenScraper::getSearchNames(const QFileInfo &info)
     }
   }
 
+  quint32 crcValue = (zipRead ? zipCrc : crc.result());
+  QByteArray md5Value = md5.result();
+  QByteArray sha1Value = sha1.result();
   if(!unpack) {
-    // For normal file reading
-    QFile romFile(info.absoluteFilePath());
-    romFile.open(QIODevice::ReadOnly);
-    while(!romFile.atEnd()) {
-      
-      QByteArray dataSeg = romFile.read(1024);
-      md5.addData(dataSeg);
-      sha1.addData(dataSeg);
-      crc.pushData(1, dataSeg.data(), dataSeg.length());
+    // For normal file reading. Usually these were already calculated along with the cache id
+    FileHashes hashes = FileHasher::getHashes(info, FileHasher::MD5 | FileHasher::SHA1 | FileHasher::CRC32);
+    if(hashes.digests != 0) {
+      crcValue = hashes.crc32;
+      md5Value = hashes.md5;
+      sha1Value = hashes.sha1;
     }
-    romFile.close();
   }
 
-  QString crcResult = QString::number(crc.releaseInstance(1), 16);
+  QString crcResult = QString::number(crcValue, 16);
   while(crcResult.length() < 8) {
     crcResult.prepend("0");
   }
-  QString md5Result = md5.result().toHex();
+  QString md5Result = md5Value.toHex();
   while(md5Result.length() < 32) {
     md5Result.prepend("0");
   }
-  QString sha1Result = sha1.result().toHex();
+  QString sha1Result = sha1Value.toHex();
   while(sha1Result.length() < 40) {
     sha1Result.prepend("0");
   }
@@ -67,8 +67,15 @@ struct Settings {
   QString cacheOptions = "";
   bool cacheResize = true;
   int jpgQuality = 95;
+  QString cacheFormat = "xml";
+  int cacheJournalLimit = 16;
+  QString cacheMediaCheck = "startup";
+  bool cacheDedup = false;
+  int httpCacheTtl = 24;
+  int httpCacheSize = 64;
   bool subdirs = true;
   bool onlyMissing = false;
+  bool missingFirst = false;
   QString startAt = "";
   QString endAt = "";
   bool pretend = false;
@@ -91,6 +98,8 @@ struct Settings {
   QString extensions = "";
   QString addExtensions = "";
   bool unpack = false;
+  bool prehash = false;
+  int prehashThreads = 0; // 0 means automatic
   bool theInFront = false;
   bool gameListBackup = false;
   bool preserveOldGameList = true;
@@ -45,6 +45,8 @@
 #endif
 
 #include "skyscraper.h"
+#include "retrypolicy.h"
+#include "filehasher.h"
 #include "strtools.h"
 
 #include "emulationstation.h"
@@ -105,7 +107,6 @@ void Skyscraper::run()
 
   doPrescrapeJobs();
 
-  doneThreads = 0;
   notFound = 0;
   found = 0;
   avgCompleteness = 0;
@@ -118,14 +119,20 @@ void Skyscraper::run()
       decProc.start("which", QStringList({"7z"}));
       decProc.waitForFinished(10000);
       if(!decProc.readAllStandardOutput().contains("7z")) {
+#ifdef WITH_ZLIB
+	// Zip files are unpacked in-process, so 7z is only needed for 7z files
+	printf("\033[1;33mCouldn't find '7z' command. Zip files will still be unpacked, but 7z files will be checksummed as they are. On Debian derivatives such as RetroPie you can install it with 'sudo apt install p7zip-full'.\033[0m\n");
+#else
 	printf("Couldn't find '7z' command. 7z is required by the '--flags unpack' flag. On Debian derivatives such as RetroPie you can install it with 'sudo apt install p7zip-full'.\n\nNow quitting...\n");
 	exit(1);
+#endif
       }
     }
   }
 
   if(!config.cacheFolder.isEmpty()) {
     cache = QSharedPointer<Cache>(new Cache(config.cacheFolder));
+    cache->setConfig(config);
     if(cache->createFolders(config.scraper)) {
       if(!cache->read() && config.scraper == "cache") {
 	printf("No resources for this platform found in the resource cache. Please specify a scraping module with '-s' to gather some resources before trying to generate a game list. Check all available modules with '--help'. You can also run Skyscraper in simple mode by typing 'Skyscraper' and follow the instructions on screen.\n\n");
@@ -172,11 +179,29 @@ void Skyscraper::run()
     state = 0;
     exit(0);
   }
+  if(config.cacheOptions == "compact") {
+    state = 1; // Ignore ctrl+c
+    cache->write();
+    state = 0;
+    exit(0);
+  }
+  if(config.cacheOptions.left(8) == "convert:") {
+    QString format = config.cacheOptions.mid(8);
+    if(format != "xml" && format != "binary") {
+      printf("Unknown cache format '%s', please use either 'xml' or 'binary'...\n", format.toStdString().c_str());
+      exit(1);
+    }
+    config.cacheFormat = format;
+    cache->setConfig(config);
+    state = 1; // Ignore ctrl+c
+    cache->write();
+    state = 0;
+    exit(0);
+  }
   if(config.cacheOptions.contains("merge:")) {
     QFileInfo mergeCacheInfo(config.cacheOptions.replace("merge:", ""));
     if(mergeCacheInfo.exists()) {
       Cache mergeCache(mergeCacheInfo.absoluteFilePath());
-      mergeCache.read();
       cache->merge(mergeCache, config.refresh, mergeCacheInfo.absoluteFilePath());
       state = 1; // Ignore ctrl+c
       cache->write();
@@ -187,6 +212,7 @@ void Skyscraper::run()
     exit(0);
   }
   cache->readPriorities();
+  cache->startMediaCheck();
 
   QDir inputDir(config.inputFolder, Platform::getFormats(config.platform, config.extensions, config.addExtensions), QDir::Name, QDir::Files);
   if(!inputDir.exists()) {
@@ -422,6 +448,15 @@ void Skyscraper::run()
     printf("\n\033[1;33mRestriction overrun!\033[0m This scraping module only allows for scraping up to %d roms at a time. You can either supply a few rom filenames on command line, or make use of the '--startat' and / or '--endat' command line options to adhere to this. Please check '--help' for more info.\n\nNow quitting...\n", config.romLimit);
     exit(0);
   }
+
+  // Scrape files this module has no cached data for first. That way a run that is interrupted or hits the request limit has spent its requests where they matter. Only the order changes, so the rom limit above still applies to all files
+  if(config.missingFirst && config.scraper != "cache" && !config.refresh &&
+     !config.cacheFolder.isEmpty()) {
+    queue->prioritize([this](const QFileInfo &info) {
+	QString cacheId = cache->getQuickId(info);
+	return cacheId.isEmpty() || !cache->hasEntries(cacheId, config.scraper);
+      });
+  }
   printf("\n");
   if(totalFiles > 0) {
     printf("Starting scraping run on \033[1;32m%d\033[0m files using \033[1;32m%d\033[0m threads.\nSit back, relax and let me do the work! :)\n\n", totalFiles, config.threads);
@@ -432,26 +467,29 @@ void Skyscraper::run()
   timer.start();
   currentFile = 1;
 
-  QList<QThread*> threadList;
-  for(int curThread = 1; curThread <= config.threads; ++curThread) {
-    QThread *thread = new QThread;
-    ScraperWorker *worker = new ScraperWorker(queue, cache, manager, config, QString::number(curThread));
-    worker->moveToThread(thread);
-    connect(thread, &QThread::started, worker, &ScraperWorker::run);
-    connect(worker, &ScraperWorker::entryReady, this, &Skyscraper::entryReady);
-    connect(worker, &ScraperWorker::allDone, this, &Skyscraper::checkThreads);
-    connect(thread, &QThread::finished, worker, &ScraperWorker::deleteLater);
-    threadList.append(thread);
-    // Do not start more threads if we have less files than allowed threads
-    if(curThread == totalFiles) {
-      config.threads = curThread;
-      break;
-    }
-  }
-  // Ready, set, GO! Start all threads
-  for(const auto thread: threadList) {
-    thread->start();
-    state = 3;
+  if(!config.cacheFolder.isEmpty()) {
+    // Keep rom digests with the quick ids so unchanged files aren't read again on later runs
+    FileHasher::setStore([this](const QFileInfo &info, FileHashes &hashes) {
+	return cache->getHashes(info, hashes);
+      }, [this](const QFileInfo &info, const FileHashes &hashes) {
+	cache->addHashes(info, hashes);
+      });
+  }
+  if(config.scraper == "screenscraper") {
+    // ScreenScraper searches by checksums, so calculate them in the same read as the cache id
+    FileHasher::setDefaultDigests(FileHasher::MD5 | FileHasher::SHA1 | FileHasher::CRC32);
+  }
+  pipeline = QSharedPointer<Pipeline>(new Pipeline(queue, cache, config));
+  connect(pipeline.data(), &Pipeline::entryReady, this, &Skyscraper::entryReady);
+  connect(pipeline.data(), &Pipeline::allDone, this, &Skyscraper::checkThreads);
+  if(config.prehash && totalFiles > 0) {
+    pipeline->prehash();
+  }
+  // Ready, set, GO! Start all stages
+  pipeline->start(totalFiles);
+  state = 3;
+  if(config.verbosity >= 1) {
+    printf("Hashing threads: \033[1;32m%d\033[0m, scraping threads: \033[1;32m%d\033[0m, processing threads: \033[1;32m%d\033[0m\n\n", pipeline->getHashThreads(), pipeline->getScraperThreads(), pipeline->getProcessThreads());
   }
 }
 
@@ -561,15 +599,11 @@ void Skyscraper::checkThreads()
 {
   QMutexLocker locker(&checkThreadMutex);
 
-  doneThreads++;
-  if(doneThreads != config.threads)
-    return;
-
   if(!config.pretend && config.scraper == "cache") {
     printf("\033[1;34m---- Game list generation run completed! YAY! ----\033[0m\n");
     if(!config.cacheFolder.isEmpty()) {
       state = 1; // Ignore ctrl+c
-      cache->write(true);
+      cache->sync(true);
       state = 0;
     }
     QString finalOutput;
@@ -593,7 +627,7 @@ void Skyscraper::checkThreads()
     printf("\033[1;34m---- Resource gathering run completed! YAY! ----\033[0m\n");
     if(!config.cacheFolder.isEmpty()) {
       state = 1; // Ignore ctrl+c
-      cache->write();
+      cache->sync();
       state = 0;
     }
   }
@@ -609,6 +643,16 @@ void Skyscraper::checkThreads()
   printf("\033[1;34mTotal number of games: %d\033[0m\n", totalFiles);
   printf("\033[1;32mSuccessfully processed games: %d\033[0m\n", found);
   printf("\033[1;33mSkipped games: %d\033[0m (Filenames saved to '\033[1;33m/home/USER/.skyscraper/%s\033[0m')\n\n", notFound, skippedFileString.toStdString().c_str());
+  if(config.verbosity >= 1 && !config.cacheFolder.isEmpty()) {
+    printf("Cache lock waits: \033[1;33m%d\033[0m (times a thread had to wait for another to access the resource cache)\n\n", cache->getLockWaits());
+    if(config.cacheResize) {
+      printf("Cached images that needed no re-encoding: \033[1;33m%d\033[0m\n\n", cache->getFastPathImages());
+    }
+  }
+  if(config.verbosity >= 1 && NetManager::getRequests() > 0) {
+    printf("Network requests: \033[1;33m%d\033[0m, TLS handshakes: \033[1;33m%d\033[0m (lower than requests means connections were reused)\n\n", NetManager::getRequests(), NetManager::getTlsHandshakes());
+  }
+  RetryPolicy::printStats();
 
   // All done, now clean up and exit to terminal
   emit finished();
@@ -710,6 +754,15 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
   if(settings.contains("unpack")) {
     config.unpack = settings.value("unpack").toBool();
   }
+  if(settings.contains("missingFirst")) {
+    config.missingFirst = settings.value("missingFirst").toBool();
+  }
+  if(settings.contains("prehash")) {
+    config.prehash = settings.value("prehash").toBool();
+  }
+  if(settings.contains("prehashThreads")) {
+    config.prehashThreads = settings.value("prehashThreads").toInt();
+  }
   if(settings.contains("interactive")) {
     config.interactive = settings.value("interactive").toBool();
   }
@@ -813,6 +866,24 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
   if(settings.contains("cacheResize")) {
     config.cacheResize = settings.value("cacheResize").toBool();
   }
+  if(settings.contains("cacheFormat")) {
+    config.cacheFormat = settings.value("cacheFormat").toString();
+  }
+  if(settings.contains("cacheJournalLimit")) {
+    config.cacheJournalLimit = settings.value("cacheJournalLimit").toInt();
+  }
+  if(settings.contains("cacheMediaCheck")) {
+    config.cacheMediaCheck = settings.value("cacheMediaCheck").toString();
+  }
+  if(settings.contains("cacheDedup")) {
+    config.cacheDedup = settings.value("cacheDedup").toBool();
+  }
+  if(settings.contains("httpCacheTtl")) {
+    config.httpCacheTtl = settings.value("httpCacheTtl").toInt();
+  }
+  if(settings.contains("httpCacheSize")) {
+    config.httpCacheSize = settings.value("httpCacheSize").toInt();
+  }
   if(settings.contains("cacheCovers")) {
     config.cacheCovers = settings.value("cacheCovers").toBool();
   }
@@ -994,6 +1065,12 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
   if(settings.contains("unpack")) {
     config.unpack = settings.value("unpack").toBool();
   }
+  if(settings.contains("missingFirst")) {
+    config.missingFirst = settings.value("missingFirst").toBool();
+  }
+  if(settings.contains("prehash")) {
+    config.prehash = settings.value("prehash").toBool();
+  }
   if(settings.contains("unattend")) {
     config.unattend = settings.value("unattend").toBool();
   }
@@ -1244,6 +1321,7 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
 
       printf("  \033[1;33mforcefilename\033[0m: Use filename as game name instead of the returned game title when generating a game list. Consider using 'nameTemplate' config.ini option instead.\n");
       printf("  \033[1;33minteractive\033[0m: Always ask user to choose best returned result from the scraping modules.\n");
+      printf("  \033[1;33mmissingfirst\033[0m: Scrapes the files that have no data from the selected scraping module in the cache first, and the rest after that. Useful when a run might be interrupted or hit the request limit of the module.\n");
       printf("  \033[1;33mnobrackets\033[0m: Disables any [] and () tags in the frontend game titles. Consider using 'nameTemplate' config.ini option instead.\n");
       printf("  \033[1;33mnocovers\033[0m: Disable covers/boxart from being cached locally. Only do this if you do not plan to use the cover artwork in 'artwork.xml'\n");
       printf("  \033[1;33mnocropblack\033[0m: Disables cropping away black borders around screenshot resources when compositing the final gamelist artwork.\n");
@@ -1254,6 +1332,7 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
       printf("  \033[1;33mnosubdirs\033[0m: Do not include input folder subdirectories when scraping.\n");
       printf("  \033[1;33mnowheels\033[0m: Disable wheels from being cached locally. Only do this if you do not plan to use the wheel artwork in 'artwork.xml'\n");
       printf("  \033[1;33monlymissing\033[0m: Tells Skyscraper to skip all files which already have any data from any source in the cache.\n");
+      printf("  \033[1;33mprehash\033[0m: Calculates the cache ids and checksums of all files using all cores before scraping starts, instead of along with the scraping threads. Useful for large first runs with modules that only allow a single thread.\n");
       printf("  \033[1;33mpretend\033[0m: Only relevant when generating a game list. It disables the game list generator and artwork compositor and only outputs the results of the potential game list generation to the terminal. Use it to check what and how the data will be combined from cached resources.\n");
       printf("  \033[1;33mrelative\033[0m: Forces all gamelist paths to be relative to rom location.\n");
       printf("  \033[1;33mskipexistingcovers\033[0m: When generating gamelists, skip processing covers that already exist in the media output folder.\n");
@@ -1266,7 +1345,7 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
       printf("  \033[1;33mtheinfront\033[0m: Forces Skyscraper to always try and move 'The' to the beginning of the game title when generating gamelists. By default 'The' will be moved to the end of the game titles.\n");
       printf("  \033[1;33munattend\033[0m: Skip initial questions when scraping. It will then always overwrite existing gamelist and not skip existing entries.\n");
       printf("  \033[1;33munattendskip\033[0m: Skip initial questions when scraping. It will then always overwrite existing gamelist and always skip existing entries.\n");
-      printf("  \033[1;33munpack\033[0m: Unpacks and checksums the file inside 7z or zip files instead of the compressed file itself. Be aware that this option requires '7z' to be installed on the system to work. Only relevant for 'screenscraper' scraping module.\n");
+      printf("  \033[1;33munpack\033[0m: Unpacks and checksums the file inside 7z or zip files instead of the compressed file itself. Zip files are unpacked by Skyscraper itself, while 7z files require '7z' to be installed on the system. Only relevant for 'screenscraper' scraping module.\n");
       printf("  \033[1;33mvideos\033[0m: Enables scraping and caching of videos for the scraping modules that support them. Beware, this takes up a lot of disk space!.\n");
       printf("\n");
       exit(0);
@@ -1277,6 +1356,8 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
 	  config.forceFilename = true;
 	} else if(flag == "interactive") {
 	  config.interactive = true;
+	} else if(flag == "missingfirst") {
+	  config.missingFirst = true;
 	} else if(flag == "nobrackets") {
 	  config.brackets = false;
 	} else if(flag == "nocovers") {
@@ -1297,6 +1378,8 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
 	  config.cacheWheels = false;
 	} else if(flag == "onlymissing") {
 	  config.onlyMissing = true;
+	} else if(flag == "prehash") {
+	  config.prehash = true;
 	} else if(flag == "pretend") {
 	  config.pretend = true;
 	} else if(flag == "relative") {
@@ -1392,6 +1475,8 @@ void Skyscraper::loadConfig(const QCommandLineParser &parser)
       printf("  \033[1;33m--cache edit:new=<TYPE>\033[0m: Let's you batch add resources of <TYPE> to the selected platform for all files or a range of files. Add a filename on command line to edit cached resources for just that one file, use '--includefrom' to edit files created with the '--cache report' option or use '--startat' and '--endat' to edit a range of roms.\n");
       printf("  \033[1;33m--cache vacuum\033[0m: Compares your romset to any cached resource and removes the resources that you no longer have roms for.\n");
       printf("  \033[1;33m--cache report:missing=<OPTION>\033[0m: Generates reports with all files that are missing the specified resources. Check '--cache report:missing=help' for more info.\n");
+      printf("  \033[1;33m--cache compact\033[0m: Writes all changes from the cache journal into the main resource cache files for the selected platform and empties the journal.\n");
+      printf("  \033[1;33m--cache convert:<FORMAT>\033[0m: Rewrites the resource cache for the selected platform in either the 'xml' or the 'binary' format. Set 'cacheFormat' in config.ini to keep using the chosen format for future runs.\n");
       printf("  \033[1;33m--cache merge:<PATH>\033[0m: Merges two resource caches together. It will merge the resource cache specified by <PATH> into the local resource cache by default. To merge into a non-default destination cache folder set it with '-d <PATH>'. Both should point to folders with the 'db.xml' inside.\n");
       printf("  \033[1;33m--cache purge:all\033[0m: Removes ALL cached resources for the selected platform.\n");
       printf("  \033[1;33m--cache purge:m=<MODULE>,t=<TYPE>\033[0m: Removes cached resources related to the selected module(m) and / or type(t). Either one can be left out in which case ALL resources from the selected module or ALL resources from the selected type will be removed.\n");
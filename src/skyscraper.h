@@ -28,7 +28,7 @@
 
 #include "netcomm.h"
 #include "netmanager.h"
-#include "scraperworker.h"
+#include "pipeline.h"
 #include "cache.h"
 #include "abstractfrontend.h"
 #include "settings.h"
@@ -79,6 +79,7 @@ private:
   AbstractFrontend *frontend;
 
   QSharedPointer<Cache> cache;
+  QSharedPointer<Pipeline> pipeline;
 
   QList<GameEntry> gameEntries;
   QList<QString> cliFiles;
@@ -87,7 +88,6 @@ private:
   QElapsedTimer timer;
   QString gameListFileString;
   QString skippedFileString;
-  int doneThreads;
   int notFound;
   int found;
   int avgSearchMatch;
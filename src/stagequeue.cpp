@@ -0,0 +1,69 @@
+/***************************************************************************
+ *            stagequeue.cpp
+ *
+ *  Sat Oct 17 23:13:51 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QMutexLocker>
+
+#include "stagequeue.h"
+
+StageQueue::StageQueue(const int &capacity)
+  : capacity(qMax(capacity, 1))
+{
+}
+
+bool StageQueue::push(const ScrapeJob &job)
+{
+  QMutexLocker locker(&mutex);
+  while(jobs.length() >= capacity && !closed) {
+    notFull.wait(&mutex);
+  }
+  if(closed) {
+    return false;
+  }
+  jobs.enqueue(job);
+  notEmpty.wakeOne();
+  return true;
+}
+
+bool StageQueue::pop(ScrapeJob &job)
+{
+  QMutexLocker locker(&mutex);
+  while(jobs.isEmpty() && !closed) {
+    notEmpty.wait(&mutex);
+  }
+  if(jobs.isEmpty()) {
+    return false;
+  }
+  job = jobs.dequeue();
+  notFull.wakeOne();
+  return true;
+}
+
+void StageQueue::close()
+{
+  QMutexLocker locker(&mutex);
+  closed = true;
+  notEmpty.wakeAll();
+  notFull.wakeAll();
+}
@@ -0,0 +1,72 @@
+/***************************************************************************
+ *            stagequeue.h
+ *
+ *  Sat Oct 17 23:13:51 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef STAGEQUEUE_H
+#define STAGEQUEUE_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QFileInfo>
+
+#include "gameentry.h"
+
+// Everything a single file carries with it from one pipeline stage to the next
+struct ScrapeJob {
+  QFileInfo info;
+  QString cacheId;
+  QString compareTitle;
+  GameEntry game;
+  QString output;
+  QString debug;
+  QString rateLimit;
+  QString limitOutput;
+  int searchMatch = 0;
+  bool fromCache = false;
+  bool done = false; // Needs no further processing, just report it
+};
+
+// Bounded queue between two pipeline stages. 'push' blocks while the queue is
+// full so a fast stage can't run away from a slow one, and 'pop' blocks until
+// a job is available. Once closed, 'push' fails and 'pop' fails as soon as the
+// remaining jobs have been taken.
+class StageQueue
+{
+public:
+  StageQueue(const int &capacity);
+  bool push(const ScrapeJob &job);
+  bool pop(ScrapeJob &job);
+  void close();
+
+private:
+  QMutex mutex;
+  QWaitCondition notEmpty;
+  QWaitCondition notFull;
+  QQueue<ScrapeJob> jobs;
+  int capacity;
+  bool closed = false;
+};
+
+#endif // STAGEQUEUE_H
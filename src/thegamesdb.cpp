@@ -34,6 +34,9 @@ TheGamesDb::TheGamesDb(Settings *config,
 {
   loadMaps();
 
+  // 'ByGameID' returns one page of 20 games at most
+  batcher = ApiBatcher::get("thegamesdb", qMin(config->threads, 20), 500);
+
   baseUrl = "https://api.thegamesdb.net/v1";
 
   searchUrlPre = "https://api.thegamesdb.net/v1/Games/ByGameName?apikey=";
@@ -98,9 +101,14 @@ void TheGamesDb::getSearchResults(QList<GameEntry> &gameEntries,
 
 void TheGamesDb::getGameData(GameEntry &game)
 {
-  netComm->request(game.url);
-  q.exec();
-  data = netComm->getData();
+  // The api accepts a comma separated list of ids, so share the request with other threads
+  data = batcher->fetch(game.id, [this, &game](const QStringList &ids) -> QByteArray {
+      QString url = game.url;
+      url.replace("?id=" + game.id + "&", "?id=" + ids.join(",") + "&");
+      netComm->request(url);
+      q.exec();
+      return netComm->getData();
+    });
   jsonDoc = QJsonDocument::fromJson(data);
   if(jsonDoc.isEmpty()) {
     printf("No returned json data, is 'thegamesdb' down?\n");
@@ -114,7 +122,13 @@ void TheGamesDb::getGameData(GameEntry &game)
     reqRemaining = 0;
   }
 
-  jsonObj = jsonDoc.object()["data"].toObject()["games"].toArray().first().toObject();
+  jsonObj = QJsonObject();
+  for(const auto &jsonGame: jsonDoc.object()["data"].toObject()["games"].toArray()) {
+    if(QString::number(jsonGame.toObject()["id"].toInt()) == game.id) {
+      jsonObj = jsonGame.toObject();
+      break;
+    }
+  }
 
   for(int a = 0; a < fetchOrder.length(); ++a) {
     switch(fetchOrder.at(a)) {
@@ -171,6 +185,7 @@ void TheGamesDb::getGameData(GameEntry &game)
       ;
     }
   }
+  fetchMedia();
 }
 
 void TheGamesDb::getReleaseDate(GameEntry &game)
@@ -225,46 +240,54 @@ void TheGamesDb::getTags(GameEntry &game)
 
 void TheGamesDb::getCover(GameEntry &game)
 {
-  netComm->request("https://cdn.thegamesdb.net/images/original/boxart/front/" + game.id + "-1.jpg");
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.coverData = netComm->getData();
-  }
+  queueMedia({"https://cdn.thegamesdb.net/images/original/boxart/front/" + game.id + "-1.jpg"}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.coverData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void TheGamesDb::getScreenshot(GameEntry &game)
 {
-  netComm->request("https://cdn.thegamesdb.net/images/original/screenshots/" + game.id + "-1.jpg");
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.screenshotData = netComm->getData();
-  }
+  queueMedia({"https://cdn.thegamesdb.net/images/original/screenshots/" + game.id + "-1.jpg"}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.screenshotData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void TheGamesDb::getWheel(GameEntry &game)
 {
-  netComm->request("https://cdn.thegamesdb.net/images/original/clearlogo/" + game.id + ".png");
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.wheelData = netComm->getData();
-  }
+  queueMedia({"https://cdn.thegamesdb.net/images/original/clearlogo/" + game.id + ".png"}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.wheelData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void TheGamesDb::getMarquee(GameEntry &game)
 {
-  netComm->request("https://cdn.thegamesdb.net/images/original/graphical/" + game.id + "-g.jpg");
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.marqueeData = netComm->getData();
-  }
+  queueMedia({"https://cdn.thegamesdb.net/images/original/graphical/" + game.id + "-g.jpg"}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.marqueeData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void TheGamesDb::loadMaps()
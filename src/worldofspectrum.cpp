@@ -134,17 +134,18 @@ void WorldOfSpectrum::getCover(GameEntry &game)
   }
   nomNom("<A HREF=\"");
   QString coverUrl = data.left(data.indexOf(coverPost.toUtf8()));
-  if(coverUrl.indexOf("http") != -1) {
-    netComm->request(coverUrl);
-  } else {
-    netComm->request(baseUrl + (coverUrl.left(1) == "/"?"":"/") + coverUrl);
-  }
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.coverData = netComm->getData();
+  if(coverUrl.indexOf("http") == -1) {
+    coverUrl.prepend(baseUrl + (coverUrl.left(1) == "/"?"":"/"));
   }
+  queueMedia({coverUrl}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.coverData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void WorldOfSpectrum::getScreenshot(GameEntry &game)
@@ -155,17 +156,18 @@ void WorldOfSpectrum::getScreenshot(GameEntry &game)
   nomNom("<IMG SRC=\"/pub/sinclair/screens/in-game", false);
   nomNom("<IMG SRC=\"");
   QString screenshotUrl = data.left(data.indexOf(screenshotPost.toUtf8()));
-  if(screenshotUrl.indexOf("http") != -1) {
-    netComm->request(screenshotUrl);
-  } else {
-    netComm->request(baseUrl + (screenshotUrl.left(1) == "/"?"":"/") + screenshotUrl);
-  }
-  q.exec();
-  QImage image;
-  if(netComm->getError() == QNetworkReply::NoError &&
-     image.loadFromData(netComm->getData())) {
-    game.screenshotData = netComm->getData();
+  if(screenshotUrl.indexOf("http") == -1) {
+    screenshotUrl.prepend(baseUrl + (screenshotUrl.left(1) == "/"?"":"/"));
   }
+  queueMedia({screenshotUrl}, [&game](const NetResult &result) {
+      QImage image;
+      if(result.getError() == QNetworkReply::NoError &&
+	 image.loadFromData(result.getData())) {
+	game.screenshotData = result.getData();
+	return true;
+      }
+      return false;
+    });
 }
 
 void WorldOfSpectrum::getReleaseDate(GameEntry &game)
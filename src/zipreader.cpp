@@ -0,0 +1,206 @@
+/***************************************************************************
+ *            zipreader.cpp
+ *
+ *  Sat Oct 17 23:22:15 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#include <QtEndian>
+
+#include <zlib.h>
+
+#include "zipreader.h"
+
+#define EOCDSIGNATURE 0x06054b50
+#define EOCDSIZE 22
+#define CDSIGNATURE 0x02014b50
+#define CDHEADERSIZE 46
+#define LOCALSIGNATURE 0x04034b50
+#define LOCALHEADERSIZE 30
+#define CHUNKSIZE 262144
+
+ZipReader::ZipReader()
+{
+}
+
+bool ZipReader::open(const QString &fileName)
+{
+  entries.clear();
+  file.setFileName(fileName);
+  if(!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  // The end of central directory record is at the very end, followed only by
+  // an optional comment of up to 64 KB
+  qint64 tailSize = qMin(file.size(), (qint64)EOCDSIZE + 65535);
+  if(tailSize < EOCDSIZE || !file.seek(file.size() - tailSize)) {
+    return false;
+  }
+  QByteArray tail = file.read(tailSize);
+  const uchar *eocd = nullptr;
+  for(int a = tail.size() - EOCDSIZE; a >= 0; --a) {
+    const uchar *candidate = (const uchar *)tail.constData() + a;
+    if(qFromLittleEndian<quint32>(candidate) == EOCDSIGNATURE) {
+      eocd = candidate;
+      break;
+    }
+  }
+  if(eocd == nullptr) {
+    return false;
+  }
+  quint16 entryCount = qFromLittleEndian<quint16>(eocd + 10);
+  quint32 cdSize = qFromLittleEndian<quint32>(eocd + 12);
+  quint32 cdOffset = qFromLittleEndian<quint32>(eocd + 16);
+  // Zip64 archives mark the real values as stored elsewhere
+  if(entryCount == 0xFFFF || cdSize == 0xFFFFFFFF || cdOffset == 0xFFFFFFFF ||
+     (qint64)cdOffset + cdSize > file.size()) {
+    return false;
+  }
+  if(!file.seek(cdOffset)) {
+    return false;
+  }
+  QByteArray cd = file.read(cdSize);
+  if(cd.size() != (int)cdSize) {
+    return false;
+  }
+  int pos = 0;
+  for(int a = 0; a < entryCount; ++a) {
+    if(pos + CDHEADERSIZE > cd.size()) {
+      return false;
+    }
+    const uchar *header = (const uchar *)cd.constData() + pos;
+    if(qFromLittleEndian<quint32>(header) != CDSIGNATURE) {
+      return false;
+    }
+    ZipEntry entry;
+    entry.flags = qFromLittleEndian<quint16>(header + 8);
+    entry.method = qFromLittleEndian<quint16>(header + 10);
+    entry.crc32 = qFromLittleEndian<quint32>(header + 16);
+    entry.compressedSize = qFromLittleEndian<quint32>(header + 20);
+    entry.size = qFromLittleEndian<quint32>(header + 24);
+    quint16 nameLength = qFromLittleEndian<quint16>(header + 28);
+    quint16 extraLength = qFromLittleEndian<quint16>(header + 30);
+    quint16 commentLength = qFromLittleEndian<quint16>(header + 32);
+    entry.localHeaderOffset = qFromLittleEndian<quint32>(header + 42);
+    if(pos + CDHEADERSIZE + nameLength > cd.size()) {
+      return false;
+    }
+    QByteArray name = cd.mid(pos + CDHEADERSIZE, nameLength);
+    // Bit 11 means the name is UTF-8
+    entry.fileName = (entry.flags & 0x0800 ? QString::fromUtf8(name) : QString::fromLatin1(name));
+    if(entry.compressedSize == 0xFFFFFFFF || entry.size == 0xFFFFFFFF ||
+       entry.localHeaderOffset == 0xFFFFFFFF) {
+      return false;
+    }
+    entries.append(entry);
+    pos += CDHEADERSIZE + nameLength + extraLength + commentLength;
+  }
+  return true;
+}
+
+QList<ZipEntry> ZipReader::getEntries()
+{
+  return entries;
+}
+
+bool ZipReader::isSupported(const ZipEntry &entry)
+{
+  // Bit 0 means encrypted. Only store and deflate can be decompressed
+  return !(entry.flags & 0x0001) && (entry.method == 0 || entry.method == 8);
+}
+
+bool ZipReader::read(const ZipEntry &entry,
+		     const std::function<void(const char *, const qint64 &)> &sink)
+{
+  if(!isSupported(entry)) {
+    return false;
+  }
+  if(!file.seek(entry.localHeaderOffset)) {
+    return false;
+  }
+  QByteArray localHeader = file.read(LOCALHEADERSIZE);
+  if(localHeader.size() != LOCALHEADERSIZE ||
+     qFromLittleEndian<quint32>((const uchar *)localHeader.constData()) != LOCALSIGNATURE) {
+    return false;
+  }
+  // Name and extra field lengths can differ from the ones in the central directory
+  qint64 dataOffset = entry.localHeaderOffset + LOCALHEADERSIZE +
+    qFromLittleEndian<quint16>((const uchar *)localHeader.constData() + 26) +
+    qFromLittleEndian<quint16>((const uchar *)localHeader.constData() + 28);
+  if(!file.seek(dataOffset)) {
+    return false;
+  }
+
+  QByteArray input(CHUNKSIZE, Qt::Uninitialized);
+  qint64 remaining = entry.compressedSize;
+  if(entry.method == 0) {
+    while(remaining > 0) {
+      qint64 bytesRead = file.read(input.data(), qMin(remaining, (qint64)CHUNKSIZE));
+      if(bytesRead <= 0) {
+	return false;
+      }
+      sink(input.constData(), bytesRead);
+      remaining -= bytesRead;
+    }
+    return true;
+  }
+
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  stream.next_in = Z_NULL;
+  stream.avail_in = 0;
+  // Negative window bits means raw deflate data without a zlib header
+  if(inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+    return false;
+  }
+  QByteArray output(CHUNKSIZE, Qt::Uninitialized);
+  qint64 produced = 0;
+  int result = Z_OK;
+  while(result != Z_STREAM_END) {
+    // Once all input is consumed, inflate is still called until it has no
+    // more output, since the last output buffer might have been exactly full
+    if(stream.avail_in == 0 && remaining > 0) {
+      qint64 bytesRead = file.read(input.data(), qMin(remaining, (qint64)CHUNKSIZE));
+      if(bytesRead <= 0) {
+	break;
+      }
+      remaining -= bytesRead;
+      stream.next_in = (Bytef *)input.data();
+      stream.avail_in = bytesRead;
+    }
+    stream.next_out = (Bytef *)output.data();
+    stream.avail_out = CHUNKSIZE;
+    result = inflate(&stream, Z_NO_FLUSH);
+    // Z_BUF_ERROR means no progress was possible, so the input ended too early
+    if(result != Z_OK && result != Z_STREAM_END) {
+      break;
+    }
+    qint64 outputSize = CHUNKSIZE - stream.avail_out;
+    if(outputSize > 0) {
+      sink(output.constData(), outputSize);
+      produced += outputSize;
+    }
+  }
+  inflateEnd(&stream);
+  return result == Z_STREAM_END && produced == entry.size;
+}
@@ -0,0 +1,64 @@
+/***************************************************************************
+ *            zipreader.h
+ *
+ *  Sat Oct 17 23:22:15 UTC 2026
+ *  Copyright 2026 Skyscraper contributors
+ *  https://github.com/muldjord/skyscraper
+ ****************************************************************************/
+/*
+ *  This file is part of skyscraper.
+ *
+ *  skyscraper is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  skyscraper is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with skyscraper; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+ */
+
+#ifndef ZIPREADER_H
+#define ZIPREADER_H
+
+#include <functional>
+
+#include <QFile>
+#include <QString>
+#include <QList>
+
+struct ZipEntry {
+  QString fileName = "";
+  quint16 flags = 0;
+  quint16 method = 0;
+  quint32 crc32 = 0;
+  qint64 compressedSize = 0;
+  qint64 size = 0;
+  qint64 localHeaderOffset = 0;
+};
+
+// Minimal zip reader for hashing the contents of zipped roms without
+// unpacking them to memory or disk. Reads the central directory for the entry
+// list and streams stored or deflated entries through a callback in chunks.
+// Zip64, encryption and other compression methods are not supported, and
+// 'open' or 'read' fails for those so the caller can fall back.
+class ZipReader
+{
+public:
+  ZipReader();
+  bool open(const QString &fileName);
+  QList<ZipEntry> getEntries();
+  static bool isSupported(const ZipEntry &entry);
+  bool read(const ZipEntry &entry, const std::function<void(const char *, const qint64 &)> &sink);
+
+private:
+  QFile file;
+  QList<ZipEntry> entries;
+};
+
+#endif // ZIPREADER_H